@@ -0,0 +1,227 @@
+#include "globalSymbols.h"
+
+static unsigned long hashSymbolName(const char *name) {
+    unsigned long hash = 2166136261UL;
+    while (*name) {
+        hash = (hash ^ (unsigned char)*name++) * 16777619UL;
+    }
+    return hash;
+}
+
+// Shards use the top bits of the hash, slots inside a shard the low bits
+static int shardOf(unsigned long hash) {
+    return (int)((hash >> 24) % GLOBAL_SYMBOL_SHARDS);
+}
+
+int initGlobalSymbolTable(GlobalSymbolTable *table) {
+    for (int i = 0; i < GLOBAL_SYMBOL_SHARDS; i++) {
+        GlobalSymbolShard *shard = &table->shards[i];
+        shard->slots = NULL;
+        shard->slotCount = 0;
+        shard->count = 0;
+        if (pthread_mutex_init(&shard->lock, NULL) != 0) {
+            fprintf(stderr, "Error: Cannot create symbol table lock\n");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void freeGlobalSymbolTable(GlobalSymbolTable *table) {
+    for (int i = 0; i < GLOBAL_SYMBOL_SHARDS; i++) {
+        GlobalSymbolShard *shard = &table->shards[i];
+        for (int j = 0; j < shard->slotCount; j++) {
+            free(shard->slots[j]);
+        }
+        free(shard->slots);
+        pthread_mutex_destroy(&shard->lock);
+    }
+}
+
+// Caller holds the shard lock
+static int growShard(GlobalSymbolShard *shard) {
+    int slotCount = shard->slotCount ? shard->slotCount * 2 : 64;
+    GlobalSymbol **slots = calloc(slotCount, sizeof(GlobalSymbol *));
+    if (slots == NULL) {
+        return 0;
+    }
+    for (int i = 0; i < shard->slotCount; i++) {
+        GlobalSymbol *sym = shard->slots[i];
+        if (sym == NULL) {
+            continue;
+        }
+        unsigned long slot = hashSymbolName(sym->name) & (slotCount - 1);
+        while (slots[slot] != NULL) {
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        slots[slot] = sym;
+    }
+    free(shard->slots);
+    shard->slots = slots;
+    shard->slotCount = slotCount;
+    return 1;
+}
+
+// Caller holds the shard lock
+static GlobalSymbol* findOrInsert(GlobalSymbolShard *shard, const Symbol *local,
+                                  unsigned long hash) {
+    if ((shard->count + 1) * 2 > shard->slotCount && !growShard(shard)) {
+        return NULL;
+    }
+    
+    unsigned long slot = hash & (shard->slotCount - 1);
+    while (shard->slots[slot] != NULL) {
+        if (strcmp(shard->slots[slot]->name, local->name) == 0) {
+            return shard->slots[slot];
+        }
+        slot = (slot + 1) & (shard->slotCount - 1);
+    }
+    
+    GlobalSymbol *sym = malloc(sizeof(GlobalSymbol));
+    if (sym == NULL) {
+        return NULL;
+    }
+    memcpy(sym->name, local->name, MAX_SYMBOL_LEN);
+    sym->type = local->type;
+    memcpy(sym->dataType, local->dataType, MAX_SYMBOL_LEN);
+    sym->lineNumber = local->lineNumber;
+    sym->occurrences = 0;
+    
+    shard->slots[slot] = sym;
+    shard->count++;
+    return sym;
+}
+
+// SymbolFlush for per-thread tables: merges a batch, taking each shard lock
+// at most once. A local symbol's usage counts repeats, so it stands for
+// usage + 1 occurrences. The lock only covers finding or creating entries;
+// counts are added after it is released.
+void mergeSymbols(void *globalTable, const Symbol *symbols, int count) {
+    GlobalSymbolTable *table = (GlobalSymbolTable *)globalTable;
+    unsigned long hashes[MAX_SYMBOLS];
+    int order[MAX_SYMBOLS];
+    GlobalSymbol *merged[MAX_SYMBOLS];
+    int starts[GLOBAL_SYMBOL_SHARDS + 1] = { 0 };
+    
+    if (count > MAX_SYMBOLS) {
+        count = MAX_SYMBOLS;
+    }
+    
+    // Counting sort the batch by shard
+    for (int i = 0; i < count; i++) {
+        hashes[i] = hashSymbolName(symbols[i].name);
+        starts[shardOf(hashes[i]) + 1]++;
+    }
+    for (int s = 0; s < GLOBAL_SYMBOL_SHARDS; s++) {
+        starts[s + 1] += starts[s];
+    }
+    int next[GLOBAL_SYMBOL_SHARDS];
+    memcpy(next, starts, sizeof(next));
+    for (int i = 0; i < count; i++) {
+        order[next[shardOf(hashes[i])]++] = i;
+    }
+    
+    for (int s = 0; s < GLOBAL_SYMBOL_SHARDS; s++) {
+        if (starts[s] == starts[s + 1]) {
+            continue;
+        }
+        GlobalSymbolShard *shard = &table->shards[s];
+        pthread_mutex_lock(&shard->lock);
+        for (int k = starts[s]; k < starts[s + 1]; k++) {
+            const Symbol *local = &symbols[order[k]];
+            GlobalSymbol *sym = findOrInsert(shard, local, hashes[order[k]]);
+            merged[k] = sym;
+            if (sym == NULL) {
+                fprintf(stderr, "Error: Out of memory merging symbol '%s'\n", local->name);
+                continue;
+            }
+            if (local->lineNumber < sym->lineNumber) {
+                sym->lineNumber = local->lineNumber;
+            }
+        }
+        pthread_mutex_unlock(&shard->lock);
+        
+        // Entries never move or go away, so they can be counted unlocked
+        for (int k = starts[s]; k < starts[s + 1]; k++) {
+            if (merged[k] != NULL) {
+                __atomic_fetch_add(&merged[k]->occurrences,
+                                   (long)symbols[order[k]].usage + 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+}
+
+GlobalSymbol* lookupGlobalSymbol(GlobalSymbolTable *table, const char *name) {
+    unsigned long hash = hashSymbolName(name);
+    GlobalSymbolShard *shard = &table->shards[shardOf(hash)];
+    GlobalSymbol *found = NULL;
+    
+    pthread_mutex_lock(&shard->lock);
+    if (shard->slotCount > 0) {
+        unsigned long slot = hash & (shard->slotCount - 1);
+        while (shard->slots[slot] != NULL) {
+            if (strcmp(shard->slots[slot]->name, name) == 0) {
+                found = shard->slots[slot];
+                break;
+            }
+            slot = (slot + 1) & (shard->slotCount - 1);
+        }
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return found;
+}
+
+long getGlobalSymbolUsage(GlobalSymbol *symbol) {
+    return __atomic_load_n(&symbol->occurrences, __ATOMIC_RELAXED) - 1;
+}
+
+int countGlobalSymbols(GlobalSymbolTable *table) {
+    int total = 0;
+    for (int i = 0; i < GLOBAL_SYMBOL_SHARDS; i++) {
+        pthread_mutex_lock(&table->shards[i].lock);
+        total += table->shards[i].count;
+        pthread_mutex_unlock(&table->shards[i].lock);
+    }
+    return total;
+}
+
+static int compareSymbolNames(const void *a, const void *b) {
+    return strcmp(((const Symbol *)a)->name, ((const Symbol *)b)->name);
+}
+
+// Prints a sorted snapshot so the report does not depend on thread timing
+void printGlobalSymbolTable(GlobalSymbolTable *table, FILE *fp) {
+    int count = countGlobalSymbols(table);
+    Symbol *snapshot = malloc((count + 1) * sizeof(Symbol));
+    int taken = 0;
+    
+    if (snapshot == NULL) {
+        fprintf(stderr, "Error: Out of memory printing %d symbols\n", count);
+        return;
+    }
+    
+    for (int i = 0; i < GLOBAL_SYMBOL_SHARDS; i++) {
+        GlobalSymbolShard *shard = &table->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        for (int j = 0; j < shard->slotCount && taken < count; j++) {
+            GlobalSymbol *sym = shard->slots[j];
+            if (sym == NULL) {
+                continue;
+            }
+            long usage = getGlobalSymbolUsage(sym);
+            Symbol *out = &snapshot[taken++];
+            memcpy(out->name, sym->name, MAX_SYMBOL_LEN);
+            out->type = sym->type;
+            memcpy(out->dataType, sym->dataType, MAX_SYMBOL_LEN);
+            out->scope = 0;
+            out->lineNumber = sym->lineNumber;
+            out->usage = usage > 2147483647L ? 2147483647 : (int)usage;
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+    
+    qsort(snapshot, taken, sizeof(Symbol), compareSymbolNames);
+    printSymbolList(snapshot, taken, fp);
+    fprintf(fp, "\n");
+    free(snapshot);
+}
@@ -0,0 +1,39 @@
+#ifndef GLOBALSYMBOLS_H
+#define GLOBALSYMBOLS_H
+
+#include <pthread.h>
+#include "symbolTable.h"
+
+#define GLOBAL_SYMBOL_SHARDS 64
+
+typedef struct {
+    char name[MAX_SYMBOL_LEN];
+    SymbolType type;
+    char dataType[MAX_SYMBOL_LEN];
+    int lineNumber;     // Earliest line seen in any file
+    long occurrences;   // Updated atomically; readable without the shard lock
+} GlobalSymbol;
+
+typedef struct {
+    pthread_mutex_t lock;
+    GlobalSymbol **slots;   // Open addressing; entries never move once created
+    int slotCount;
+    int count;
+} GlobalSymbolShard;
+
+// Identifier map shared by every lexer thread. Each name belongs to one
+// shard, so threads merging different names rarely contend.
+typedef struct {
+    GlobalSymbolShard shards[GLOBAL_SYMBOL_SHARDS];
+} GlobalSymbolTable;
+
+// Function declarations
+int initGlobalSymbolTable(GlobalSymbolTable *table);
+void freeGlobalSymbolTable(GlobalSymbolTable *table);
+void mergeSymbols(void *globalTable, const Symbol *symbols, int count);
+GlobalSymbol* lookupGlobalSymbol(GlobalSymbolTable *table, const char *name);
+long getGlobalSymbolUsage(GlobalSymbol *symbol);
+int countGlobalSymbols(GlobalSymbolTable *table);
+void printGlobalSymbolTable(GlobalSymbolTable *table, FILE *fp);
+
+#endif
@@ -0,0 +1,255 @@
+#include "include.h"
+#include "source.h"
+#include <limits.h>
+
+static unsigned long hashPath(const char *path) {
+    unsigned long hash = 2166136261UL;
+    while (*path) {
+        hash = (hash ^ (unsigned char)*path++) * 16777619UL;
+    }
+    return hash;
+}
+
+void initHeaderCache(HeaderCache *cache) {
+    memset(cache, 0, sizeof(*cache));
+}
+
+int addIncludeDir(HeaderCache *cache, const char *dir) {
+    if (cache->includeDirCount >= MAX_INCLUDE_DIRS) {
+        fprintf(stderr, "Error: Too many include directories (max %d)\n", MAX_INCLUDE_DIRS);
+        return 0;
+    }
+    cache->includeDirs[cache->includeDirCount++] = dir;
+    return 1;
+}
+
+void freeHeaderCache(HeaderCache *cache) {
+    for (int i = 0; i < cache->slotCount; i++) {
+        HeaderEntry *entry = cache->slots[i];
+        if (entry != NULL) {
+            free(entry->path);
+            free(entry->tokens.tokens);
+            free(entry);
+        }
+    }
+    free(cache->slots);
+    cache->slots = NULL;
+    cache->slotCount = 0;
+    cache->headerCount = 0;
+}
+
+// TokenSink that appends to a TokenStream
+static void appendStreamToken(void *context, TokenType type, const char *lexeme,
+                              int line, int col, int value) {
+    TokenStream *stream = (TokenStream *)context;
+    
+    if (stream->count == stream->capacity) {
+        int capacity = stream->capacity ? stream->capacity * 2 : 256;
+        Token *tokens = realloc(stream->tokens, capacity * sizeof(Token));
+        if (tokens == NULL) {
+            fprintf(stderr, "Error: Out of memory for %d tokens\n", capacity);
+            exit(1);
+        }
+        stream->tokens = tokens;
+        stream->capacity = capacity;
+    }
+    
+    Token *token = &stream->tokens[stream->count++];
+    token->type = type;
+    strncpy(token->lexeme, lexeme, MAX_LEXEME_LEN - 1);
+    token->lexeme[MAX_LEXEME_LEN - 1] = '\0';
+    token->lineNumber = line;
+    token->columnNumber = col;
+    token->tokenValue = value;
+}
+
+// Lexes a file with directives enabled; returns its error count or -1
+static int lexFileTokens(const char *path, TokenStream *stream) {
+    SourceFile source;
+    Lexer *lexer = malloc(sizeof(Lexer));
+    
+    if (lexer == NULL || !openSourceFile(&source, path)) {
+        free(lexer);
+        return -1;
+    }
+    
+    initBufferLexer(lexer, source.data, (int)source.length, 0, 1);
+    lexer->directives = 1;
+    lexer->quiet = 1;
+    setTokenSink(lexer, appendStreamToken, stream);
+    tokenize(lexer);
+    
+    int errors = lexer->errorCount;
+    freeLexer(lexer);
+    free(lexer);
+    closeSourceFile(&source);
+    return errors;
+}
+
+static int growCache(HeaderCache *cache) {
+    int slotCount = cache->slotCount ? cache->slotCount * 2 : 256;
+    HeaderEntry **slots = calloc(slotCount, sizeof(HeaderEntry *));
+    if (slots == NULL) {
+        return 0;
+    }
+    for (int i = 0; i < cache->slotCount; i++) {
+        HeaderEntry *entry = cache->slots[i];
+        if (entry == NULL) {
+            continue;
+        }
+        unsigned long slot = hashPath(entry->path) & (slotCount - 1);
+        while (slots[slot] != NULL) {
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        slots[slot] = entry;
+    }
+    free(cache->slots);
+    cache->slots = slots;
+    cache->slotCount = slotCount;
+    return 1;
+}
+
+// Returns the cached header at canonical path, lexing it on first use
+static HeaderEntry* loadHeader(HeaderCache *cache, const char *canonical) {
+    if ((cache->headerCount + 1) * 2 > cache->slotCount && !growCache(cache)) {
+        return NULL;
+    }
+    
+    unsigned long slot = hashPath(canonical) & (cache->slotCount - 1);
+    while (cache->slots[slot] != NULL) {
+        if (strcmp(cache->slots[slot]->path, canonical) == 0) {
+            cache->hits++;
+            return cache->slots[slot];
+        }
+        slot = (slot + 1) & (cache->slotCount - 1);
+    }
+    
+    HeaderEntry *entry = calloc(1, sizeof(HeaderEntry));
+    size_t pathLen = strlen(canonical);
+    if (entry == NULL || (entry->path = malloc(pathLen + 1)) == NULL) {
+        free(entry);
+        return NULL;
+    }
+    memcpy(entry->path, canonical, pathLen + 1);
+    entry->errorCount = lexFileTokens(canonical, &entry->tokens);
+    entry->lastUnit = 0;
+    
+    cache->misses++;
+    cache->slots[slot] = entry;
+    cache->headerCount++;
+    return entry;
+}
+
+// Looks for name beside the including file, then in each include directory
+static int resolveInclude(HeaderCache *cache, const char *includer, const char *name,
+                          char *resolved) {
+    char candidate[MAX_PATH_LEN];
+    const char *slash = strrchr(includer, '/');
+    
+    if (name[0] == '/' || slash == NULL) {
+        snprintf(candidate, sizeof(candidate), "%s", name);
+    } else {
+        snprintf(candidate, sizeof(candidate), "%.*s/%s", (int)(slash - includer), includer, name);
+    }
+    if (realpath(candidate, resolved) != NULL) {
+        return 1;
+    }
+    
+    for (int i = 0; i < cache->includeDirCount && name[0] != '/'; i++) {
+        snprintf(candidate, sizeof(candidate), "%s/%s", cache->includeDirs[i], name);
+        if (realpath(candidate, resolved) != NULL) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void spliceTokens(HeaderCache *cache, const char *path, const TokenStream *stream,
+                         TokenSink sink, void *context, UnitStats *stats, int depth) {
+    for (int i = 0; i < stream->count; i++) {
+        const Token *token = &stream->tokens[i];
+        
+        // Only the unit itself ends the token stream
+        if (token->type == TOKEN_EOF && depth > 0) {
+            continue;
+        }
+        sink(context, token->type, token->lexeme, token->lineNumber,
+             token->columnNumber, token->tokenValue);
+        stats->tokens++;
+        if (depth > 0) {
+            stats->headerTokens++;
+        }
+        
+        if (token->type != TOKEN_DIRECTIVE || strcmp(token->lexeme, "#include") != 0 ||
+            i + 1 >= stream->count || stream->tokens[i + 1].type != TOKEN_STRING ||
+            stream->tokens[i + 1].lineNumber != token->lineNumber) {
+            continue;
+        }
+        
+        // Emit the "name" token, then the header's tokens in its place
+        const Token *header = &stream->tokens[++i];
+        sink(context, header->type, header->lexeme, header->lineNumber,
+             header->columnNumber, header->tokenValue);
+        stats->tokens++;
+        if (depth > 0) {
+            stats->headerTokens++;
+        }
+        
+        char name[MAX_LEXEME_LEN];
+        char resolved[PATH_MAX];
+        int nameLen = strlen(header->lexeme) - 2;
+        if (nameLen <= 0) {
+            continue;
+        }
+        memcpy(name, header->lexeme + 1, nameLen);
+        name[nameLen] = '\0';
+        
+        if (!resolveInclude(cache, path, name, resolved)) {
+            fprintf(stderr, "Warning: Cannot find include \"%s\" from '%s'\n", name, path);
+            stats->missing++;
+            continue;
+        }
+        // A header that includes the unit back gets nothing; the unit is
+        // already being spliced
+        if (strcmp(resolved, cache->unitPath) == 0) {
+            continue;
+        }
+        
+        HeaderEntry *entry = loadHeader(cache, resolved);
+        if (entry == NULL) {
+            fprintf(stderr, "Error: Out of memory caching '%s'\n", resolved);
+            continue;
+        }
+        // Spliced once per unit, as if every header had an include guard;
+        // this also stops include cycles
+        if (entry->lastUnit == cache->unit) {
+            continue;
+        }
+        entry->lastUnit = cache->unit;
+        stats->headers++;
+        stats->errors += entry->errorCount > 0 ? entry->errorCount : 0;
+        spliceTokens(cache, entry->path, &entry->tokens, sink, context, stats, depth + 1);
+    }
+}
+
+// Lexes the unit at path and sends its tokens, with quoted includes
+// expanded in place from the cache, to sink. Returns 0 if path is unreadable.
+int expandTranslationUnit(HeaderCache *cache, const char *path, TokenSink sink,
+                          void *context, UnitStats *stats) {
+    TokenStream unit = { NULL, 0, 0 };
+    
+    memset(stats, 0, sizeof(*stats));
+    int errors = lexFileTokens(path, &unit);
+    if (errors < 0) {
+        return 0;
+    }
+    
+    cache->unit++;
+    if (realpath(path, cache->unitPath) == NULL) {
+        cache->unitPath[0] = '\0';
+    }
+    stats->errors = errors;
+    spliceTokens(cache, path, &unit, sink, context, stats, 0);
+    free(unit.tokens);
+    return 1;
+}
@@ -0,0 +1,53 @@
+#ifndef INCLUDE_H
+#define INCLUDE_H
+
+#include "lexer.h"
+#include <limits.h>
+
+#define MAX_INCLUDE_DIRS 64
+#define MAX_PATH_LEN 4096
+
+// Growable token array; unlike TokenList it has no fixed limit
+typedef struct {
+    Token *tokens;
+    int count;
+    int capacity;
+} TokenStream;
+
+// A header lexed once per run and replayed for every unit that includes it
+typedef struct {
+    char *path;         // Canonical path, the cache key
+    TokenStream tokens;
+    int errorCount;
+    int lastUnit;       // Unit that last spliced it; headers splice once per unit
+} HeaderEntry;
+
+typedef struct {
+    const char *includeDirs[MAX_INCLUDE_DIRS];
+    int includeDirCount;
+    HeaderEntry **slots;    // Open addressing on path
+    int slotCount;
+    int headerCount;
+    long hits;
+    long misses;
+    int unit;               // Current translation unit number
+    char unitPath[PATH_MAX];    // Canonical path of the current unit
+} HeaderCache;
+
+// Per-unit totals from expandTranslationUnit
+typedef struct {
+    long tokens;
+    long headerTokens;
+    int headers;
+    int errors;
+    int missing;        // Quoted includes that resolved to no file
+} UnitStats;
+
+// Function declarations
+void initHeaderCache(HeaderCache *cache);
+int addIncludeDir(HeaderCache *cache, const char *dir);
+void freeHeaderCache(HeaderCache *cache);
+int expandTranslationUnit(HeaderCache *cache, const char *path, TokenSink sink,
+                          void *context, UnitStats *stats);
+
+#endif
@@ -13,20 +13,113 @@ TokenType keywordTypes[] = {
 
 #define NUM_KEYWORDS 11
 
-void initLexer(Lexer *lexer, const char *input) {
-    strncpy(lexer->input, input, MAX_INPUT_LEN - 1);
-    lexer->input[MAX_INPUT_LEN - 1] = '\0';
+static void resetLexerState(Lexer *lexer) {
     lexer->position = 0;
     lexer->lineNumber = 1;
     lexer->columnNumber = 1;
     lexer->errorCount = 0;
     lexer->warningCount = 0;
+    lexer->tokenSink = NULL;
+    lexer->sinkContext = NULL;
+    lexer->ownsInput = 1;
+    lexer->stopPosition = -1;
+    lexer->quiet = 0;
+    lexer->directives = 0;
+    lexer->lastTokenLine = 0;
+    lexer->tokenStart = 0;
     initTokenList(&lexer->tokenList);
     initSymbolTable(&lexer->symbolTable);
 }
 
+void initLexer(Lexer *lexer, const char *input) {
+    int length = strlen(input);
+    
+    resetLexerState(lexer);
+    lexer->stream = NULL;
+    lexer->input = malloc(length + 1);
+    if (lexer->input == NULL) {
+        fprintf(stderr, "Error: Out of memory for input\n");
+        exit(1);
+    }
+    memcpy(lexer->input, input, length + 1);
+    lexer->length = length;
+    lexer->capacity = length;
+}
+
+// Lexes from a stream through a fixed window; memory stays bounded by windowSize
+int initStreamLexer(Lexer *lexer, FILE *stream, int windowSize) {
+    if (windowSize < MIN_WINDOW_LEN) {
+        windowSize = MIN_WINDOW_LEN;
+    }
+    
+    resetLexerState(lexer);
+    lexer->symbolTable.bounded = 1;
+    lexer->stream = stream;
+    lexer->length = 0;
+    lexer->capacity = windowSize;
+    lexer->input = malloc(windowSize + 1);
+    if (lexer->input == NULL) {
+        fprintf(stderr, "Error: Out of memory for a %d byte window\n", windowSize);
+        lexer->stream = NULL;
+        lexer->capacity = 0;
+        return 0;
+    }
+    lexer->input[0] = '\0';
+    return 1;
+}
+
+// Lexes a caller-owned buffer, which must outlive the lexer, starting at
+// position. position must be a line start outside any comment or literal.
+void initBufferLexer(Lexer *lexer, const char *input, int length,
+                     int position, int lineNumber) {
+    resetLexerState(lexer);
+    lexer->symbolTable.bounded = 1;
+    lexer->stream = NULL;
+    lexer->ownsInput = 0;
+    lexer->input = (char *)input;
+    lexer->length = length;
+    lexer->capacity = length;
+    lexer->position = position;
+    lexer->lineNumber = lineNumber;
+}
+
+void setTokenSink(Lexer *lexer, TokenSink sink, void *context) {
+    lexer->tokenSink = sink;
+    lexer->sinkContext = context;
+}
+
+void freeLexer(Lexer *lexer) {
+    if (lexer->ownsInput) {
+        free(lexer->input);
+    }
+    lexer->input = NULL;
+    lexer->length = 0;
+    lexer->capacity = 0;
+}
+
+// Slides the window: consumed bytes are dropped and the rest is topped up.
+// Scanners copy lexemes as they go, so nothing before position is needed.
+static int refillWindow(Lexer *lexer) {
+    if (lexer->stream == NULL) {
+        return 0;
+    }
+    
+    int keep = lexer->length - lexer->position;
+    memmove(lexer->input, lexer->input + lexer->position, keep);
+    lexer->length = keep;
+    lexer->position = 0;
+    
+    size_t bytesRead = fread(lexer->input + keep, 1, lexer->capacity - keep, lexer->stream);
+    lexer->length += bytesRead;
+    lexer->input[lexer->length] = '\0';
+    if (bytesRead == 0) {
+        lexer->stream = NULL;
+    }
+    return bytesRead > 0;
+}
+
 char getCurrentChar(Lexer *lexer) {
-    if (lexer->position >= strlen(lexer->input)) {
+    if (lexer->position >= lexer->length && !refillWindow(lexer)) {
         return '\0';
     }
     return lexer->input[lexer->position];
@@ -34,13 +127,22 @@ char getCurrentChar(Lexer *lexer) {
 
 char peekChar(Lexer *lexer, int offset) {
     int pos = lexer->position + offset;
-    if (pos >= strlen(lexer->input)) {
-        return '\0';
+    if (pos >= lexer->length) {
+        if (!refillWindow(lexer)) {
+            return '\0';
+        }
+        pos = lexer->position + offset;
+        if (pos >= lexer->length) {
+            return '\0';
+        }
     }
     return lexer->input[pos];
 }
 
 void advance(Lexer *lexer) {
+    if (lexer->position >= lexer->length && !refillWindow(lexer)) {
+        return;
+    }
     if (lexer->input[lexer->position] == '\n') {
         lexer->lineNumber++;
         lexer->columnNumber = 1;
@@ -103,10 +205,17 @@ void skipComment(Lexer *lexer) {
     }
 }
 
+// Keeps consuming past MAX_LEXEME_LEN but stores only what fits
+static void appendLexemeChar(char *buffer, int *bufIndex, char c) {
+    if (*bufIndex < MAX_LEXEME_LEN - 1) {
+        buffer[(*bufIndex)++] = c;
+    }
+}
+
 void scanNumber(Lexer *lexer, char *buffer) {
     int bufIndex = 0;
     while (isdigit(getCurrentChar(lexer)) || getCurrentChar(lexer) == '.') {
-        buffer[bufIndex++] = getCurrentChar(lexer);
+        appendLexemeChar(buffer, &bufIndex, getCurrentChar(lexer));
         advance(lexer);
     }
     buffer[bufIndex] = '\0';
@@ -115,7 +224,7 @@ void scanNumber(Lexer *lexer, char *buffer) {
 void scanIdentifier(Lexer *lexer, char *buffer) {
     int bufIndex = 0;
     while (isalnum(getCurrentChar(lexer)) || getCurrentChar(lexer) == '_') {
-        buffer[bufIndex++] = getCurrentChar(lexer);
+        appendLexemeChar(buffer, &bufIndex, getCurrentChar(lexer));
         advance(lexer);
     }
     buffer[bufIndex] = '\0';
@@ -123,25 +232,25 @@ void scanIdentifier(Lexer *lexer, char *buffer) {
 
 void scanString(Lexer *lexer, char *buffer) {
     int bufIndex = 0;
-    buffer[bufIndex++] = '"';
+    appendLexemeChar(buffer, &bufIndex, '"');
     advance(lexer);
     
     while (getCurrentChar(lexer) != '"' && getCurrentChar(lexer) != '\0') {
         if (getCurrentChar(lexer) == '\\') {
-            buffer[bufIndex++] = getCurrentChar(lexer);
+            appendLexemeChar(buffer, &bufIndex, getCurrentChar(lexer));
             advance(lexer);
             if (getCurrentChar(lexer) != '\0') {
-                buffer[bufIndex++] = getCurrentChar(lexer);
+                appendLexemeChar(buffer, &bufIndex, getCurrentChar(lexer));
                 advance(lexer);
             }
         } else {
-            buffer[bufIndex++] = getCurrentChar(lexer);
+            appendLexemeChar(buffer, &bufIndex, getCurrentChar(lexer));
             advance(lexer);
         }
     }
     
     if (getCurrentChar(lexer) == '"') {
-        buffer[bufIndex++] = '"';
+        appendLexemeChar(buffer, &bufIndex, '"');
         advance(lexer);
     } else {
         reportError(lexer, "Unterminated string");
@@ -151,23 +260,23 @@ void scanString(Lexer *lexer, char *buffer) {
 
 void scanCharLiteral(Lexer *lexer, char *buffer) {
     int bufIndex = 0;
-    buffer[bufIndex++] = '\'';
+    appendLexemeChar(buffer, &bufIndex, '\'');
     advance(lexer);
     
     if (getCurrentChar(lexer) == '\\') {
-        buffer[bufIndex++] = getCurrentChar(lexer);
+        appendLexemeChar(buffer, &bufIndex, getCurrentChar(lexer));
         advance(lexer);
         if (getCurrentChar(lexer) != '\0') {
-            buffer[bufIndex++] = getCurrentChar(lexer);
+            appendLexemeChar(buffer, &bufIndex, getCurrentChar(lexer));
             advance(lexer);
         }
     } else {
-        buffer[bufIndex++] = getCurrentChar(lexer);
+        appendLexemeChar(buffer, &bufIndex, getCurrentChar(lexer));
         advance(lexer);
     }
     
     if (getCurrentChar(lexer) == '\'') {
-        buffer[bufIndex++] = '\'';
+        appendLexemeChar(buffer, &bufIndex, '\'');
         advance(lexer);
     } else {
         reportError(lexer, "Unterminated character literal");
@@ -175,18 +284,48 @@ void scanCharLiteral(Lexer *lexer, char *buffer) {
     buffer[bufIndex] = '\0';
 }
 
+// "#  include" becomes "#include"; the rest of the line is lexed normally
+void scanDirective(Lexer *lexer, char *buffer) {
+    int bufIndex = 0;
+    appendLexemeChar(buffer, &bufIndex, '#');
+    advance(lexer);
+    
+    while (getCurrentChar(lexer) == ' ' || getCurrentChar(lexer) == '\t') {
+        advance(lexer);
+    }
+    while (isalnum(getCurrentChar(lexer)) || getCurrentChar(lexer) == '_') {
+        appendLexemeChar(buffer, &bufIndex, getCurrentChar(lexer));
+        advance(lexer);
+    }
+    buffer[bufIndex] = '\0';
+}
+
 void reportError(Lexer *lexer, const char *message) {
-    fprintf(stderr, "Error at Line %d, Column %d: %s\n",
-            lexer->lineNumber, lexer->columnNumber, message);
+    if (!lexer->quiet) {
+        fprintf(stderr, "Error at Line %d, Column %d: %s\n",
+                lexer->lineNumber, lexer->columnNumber, message);
+    }
     lexer->errorCount++;
 }
 
 void reportWarning(Lexer *lexer, const char *message) {
-    fprintf(stderr, "Warning at Line %d, Column %d: %s\n",
-            lexer->lineNumber, lexer->columnNumber, message);
+    if (!lexer->quiet) {
+        fprintf(stderr, "Warning at Line %d, Column %d: %s\n",
+                lexer->lineNumber, lexer->columnNumber, message);
+    }
     lexer->warningCount++;
 }
 
+static void emitToken(Lexer *lexer, TokenType type, const char *lexeme,
+                      int line, int col, int value) {
+    lexer->lastTokenLine = lexer->lineNumber;
+    if (lexer->tokenSink != NULL) {
+        lexer->tokenSink(lexer->sinkContext, type, lexeme, line, col, value);
+    } else {
+        addToken(&lexer->tokenList, type, lexeme, line, col, value);
+    }
+}
+
 void tokenize(Lexer *lexer) {
     char buffer[MAX_LEXEME_LEN];
     
@@ -195,6 +334,11 @@ void tokenize(Lexer *lexer) {
         
         if (getCurrentChar(lexer) == '\0') break;
         
+        // Windowed lexing ends between tokens, without an EOF token
+        if (lexer->stopPosition >= 0 && lexer->position >= lexer->stopPosition) {
+            return;
+        }
+        
         // Handle comments
         if (getCurrentChar(lexer) == '/' && 
             (peekChar(lexer, 1) == '/' || peekChar(lexer, 1) == '*')) {
@@ -204,32 +348,39 @@ void tokenize(Lexer *lexer) {
         
         int startLine = lexer->lineNumber;
         int startCol = lexer->columnNumber;
+        lexer->tokenStart = lexer->position;
         
         // Numbers
         if (isdigit(getCurrentChar(lexer))) {
             scanNumber(lexer, buffer);
             int value = atoi(buffer);
-            addToken(&lexer->tokenList, TOKEN_NUM, buffer, startLine, startCol, value);
+            emitToken(lexer, TOKEN_NUM, buffer, startLine, startCol, value);
         }
         // Strings
         else if (getCurrentChar(lexer) == '"') {
             scanString(lexer, buffer);
-            addToken(&lexer->tokenList, TOKEN_STRING, buffer, startLine, startCol, 0);
+            emitToken(lexer, TOKEN_STRING, buffer, startLine, startCol, 0);
         }
         // Character literals
         else if (getCurrentChar(lexer) == '\'') {
             scanCharLiteral(lexer, buffer);
-            addToken(&lexer->tokenList, TOKEN_CHAR_LIT, buffer, startLine, startCol, 0);
+            emitToken(lexer, TOKEN_CHAR_LIT, buffer, startLine, startCol, 0);
+        }
+        // Preprocessor directives, only as the first token on a line
+        else if (lexer->directives && getCurrentChar(lexer) == '#' &&
+                 lexer->lastTokenLine < lexer->lineNumber) {
+            scanDirective(lexer, buffer);
+            emitToken(lexer, TOKEN_DIRECTIVE, buffer, startLine, startCol, 0);
         }
         // Identifiers and Keywords
         else if (isalpha(getCurrentChar(lexer)) || getCurrentChar(lexer) == '_') {
             scanIdentifier(lexer, buffer);
             if (isKeyword(buffer)) {
                 TokenType keywordType = getKeywordType(buffer);
-                addToken(&lexer->tokenList, keywordType, buffer, startLine, startCol, 0);
+                emitToken(lexer, keywordType, buffer, startLine, startCol, 0);
                 addSymbol(&lexer->symbolTable, buffer, SYMBOL_KEYWORD, "keyword", 0, startLine);
             } else {
-                addToken(&lexer->tokenList, TOKEN_ID, buffer, startLine, startCol, 0);
+                emitToken(lexer, TOKEN_ID, buffer, startLine, startCol, 0);
                 if (lookupSymbol(&lexer->symbolTable, buffer) == NULL) {
                     addSymbol(&lexer->symbolTable, buffer, SYMBOL_VARIABLE, "unknown", 0, startLine);
                 } else {
@@ -248,9 +399,9 @@ void tokenize(Lexer *lexer) {
                     if (peekChar(lexer, 1) == '+') {
                         advance(lexer);
                         strcpy(buffer, "++");
-                        addToken(&lexer->tokenList, TOKEN_INC, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_INC, buffer, startLine, startCol, 0);
                     } else {
-                        addToken(&lexer->tokenList, TOKEN_PLUS, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_PLUS, buffer, startLine, startCol, 0);
                     }
                     advance(lexer);
                     break;
@@ -259,29 +410,29 @@ void tokenize(Lexer *lexer) {
                     if (peekChar(lexer, 1) == '-') {
                         advance(lexer);
                         strcpy(buffer, "--");
-                        addToken(&lexer->tokenList, TOKEN_DEC, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_DEC, buffer, startLine, startCol, 0);
                     } else if (peekChar(lexer, 1) == '>') {
                         advance(lexer);
                         strcpy(buffer, "->");
-                        addToken(&lexer->tokenList, TOKEN_ARROW, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_ARROW, buffer, startLine, startCol, 0);
                     } else {
-                        addToken(&lexer->tokenList, TOKEN_MINUS, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_MINUS, buffer, startLine, startCol, 0);
                     }
                     advance(lexer);
                     break;
                     
                 case '*':
-                    addToken(&lexer->tokenList, TOKEN_MUL, buffer, startLine, startCol, 0);
+                    emitToken(lexer, TOKEN_MUL, buffer, startLine, startCol, 0);
                     advance(lexer);
                     break;
                     
                 case '/':
-                    addToken(&lexer->tokenList, TOKEN_DIV, buffer, startLine, startCol, 0);
+                    emitToken(lexer, TOKEN_DIV, buffer, startLine, startCol, 0);
                     advance(lexer);
                     break;
                     
                 case '%':
-                    addToken(&lexer->tokenList, TOKEN_MOD, buffer, startLine, startCol, 0);
+                    emitToken(lexer, TOKEN_MOD, buffer, startLine, startCol, 0);
                     advance(lexer);
                     break;
                     
@@ -289,9 +440,9 @@ void tokenize(Lexer *lexer) {
                     if (peekChar(lexer, 1) == '=') {
                         advance(lexer);
                         strcpy(buffer, "==");
-                        addToken(&lexer->tokenList, TOKEN_EQ, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_EQ, buffer, startLine, startCol, 0);
                     } else {
-                        addToken(&lexer->tokenList, TOKEN_ASSIGN, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_ASSIGN, buffer, startLine, startCol, 0);
                     }
                     advance(lexer);
                     break;
@@ -300,9 +451,9 @@ void tokenize(Lexer *lexer) {
                     if (peekChar(lexer, 1) == '=') {
                         advance(lexer);
                         strcpy(buffer, "!=");
-                        addToken(&lexer->tokenList, TOKEN_NE, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_NE, buffer, startLine, startCol, 0);
                     } else {
-                        addToken(&lexer->tokenList, TOKEN_NOT, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_NOT, buffer, startLine, startCol, 0);
                     }
                     advance(lexer);
                     break;
@@ -311,13 +462,13 @@ void tokenize(Lexer *lexer) {
                     if (peekChar(lexer, 1) == '=') {
                         advance(lexer);
                         strcpy(buffer, "<=");
-                        addToken(&lexer->tokenList, TOKEN_LE, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_LE, buffer, startLine, startCol, 0);
                     } else if (peekChar(lexer, 1) == '<') {
                         advance(lexer);
                         strcpy(buffer, "<<");
-                        addToken(&lexer->tokenList, TOKEN_LSHIFT, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_LSHIFT, buffer, startLine, startCol, 0);
                     } else {
-                        addToken(&lexer->tokenList, TOKEN_LT, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_LT, buffer, startLine, startCol, 0);
                     }
                     advance(lexer);
                     break;
@@ -326,13 +477,13 @@ void tokenize(Lexer *lexer) {
                     if (peekChar(lexer, 1) == '=') {
                         advance(lexer);
                         strcpy(buffer, ">=");
-                        addToken(&lexer->tokenList, TOKEN_GE, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_GE, buffer, startLine, startCol, 0);
                     } else if (peekChar(lexer, 1) == '>') {
                         advance(lexer);
                         strcpy(buffer, ">>");
-                        addToken(&lexer->tokenList, TOKEN_RSHIFT, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_RSHIFT, buffer, startLine, startCol, 0);
                     } else {
-                        addToken(&lexer->tokenList, TOKEN_GT, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_GT, buffer, startLine, startCol, 0);
                     }
                     advance(lexer);
                     break;
@@ -341,9 +492,9 @@ void tokenize(Lexer *lexer) {
                     if (peekChar(lexer, 1) == '&') {
                         advance(lexer);
                         strcpy(buffer, "&&");
-                        addToken(&lexer->tokenList, TOKEN_AND, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_AND, buffer, startLine, startCol, 0);
                     } else {
-                        addToken(&lexer->tokenList, TOKEN_BITAND, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_BITAND, buffer, startLine, startCol, 0);
                     }
                     advance(lexer);
                     break;
@@ -352,65 +503,65 @@ void tokenize(Lexer *lexer) {
                     if (peekChar(lexer, 1) == '|') {
                         advance(lexer);
                         strcpy(buffer, "||");
-                        addToken(&lexer->tokenList, TOKEN_OR, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_OR, buffer, startLine, startCol, 0);
                     } else {
-                        addToken(&lexer->tokenList, TOKEN_BITOR, buffer, startLine, startCol, 0);
+                        emitToken(lexer, TOKEN_BITOR, buffer, startLine, startCol, 0);
                     }
                     advance(lexer);
                     break;
                     
                 case '^':
-                    addToken(&lexer->tokenList, TOKEN_BITXOR, buffer, startLine, startCol, 0);
+                    emitToken(lexer, TOKEN_BITXOR, buffer, startLine, startCol, 0);
                     advance(lexer);
                     break;
                     
                 case '(':
-                    addToken(&lexer->tokenList, TOKEN_LPAREN, buffer, startLine, startCol, 0);
+                    emitToken(lexer, TOKEN_LPAREN, buffer, startLine, startCol, 0);
                     advance(lexer);
                     break;
                     
                 case ')':
-                    addToken(&lexer->tokenList, TOKEN_RPAREN, buffer, startLine, startCol, 0);
+                    emitToken(lexer, TOKEN_RPAREN, buffer, startLine, startCol, 0);
                     advance(lexer);
                     break;
                     
                 case '{':
-                    addToken(&lexer->tokenList, TOKEN_LBRACE, buffer, startLine, startCol, 0);
+                    emitToken(lexer, TOKEN_LBRACE, buffer, startLine, startCol, 0);
                     advance(lexer);
                     break;
                     
                 case '}':
-                    addToken(&lexer->tokenList, TOKEN_RBRACE, buffer, startLine, startCol, 0);
+                    emitToken(lexer, TOKEN_RBRACE, buffer, startLine, startCol, 0);
                     advance(lexer);
                     break;
                     
                 case '[':
-                    addToken(&lexer->tokenList, TOKEN_LBRACKET, buffer, startLine, startCol, 0);
+                    emitToken(lexer, TOKEN_LBRACKET, buffer, startLine, startCol, 0);
                     advance(lexer);
                     break;
                     
                 case ']':
-                    addToken(&lexer->tokenList, TOKEN_RBRACKET, buffer, startLine, startCol, 0);
+                    emitToken(lexer, TOKEN_RBRACKET, buffer, startLine, startCol, 0);
                     advance(lexer);
                     break;
                     
                 case ';':
-                    addToken(&lexer->tokenList, TOKEN_SEMICOLON, buffer, startLine, startCol, 0);
+                    emitToken(lexer, TOKEN_SEMICOLON, buffer, startLine, startCol, 0);
                     advance(lexer);
                     break;
                     
                 case ',':
-                    addToken(&lexer->tokenList, TOKEN_COMMA, buffer, startLine, startCol, 0);
+                    emitToken(lexer, TOKEN_COMMA, buffer, startLine, startCol, 0);
                     advance(lexer);
                     break;
                     
                 case '.':
-                    addToken(&lexer->tokenList, TOKEN_DOT, buffer, startLine, startCol, 0);
+                    emitToken(lexer, TOKEN_DOT, buffer, startLine, startCol, 0);
                     advance(lexer);
                     break;
                     
                 case ':':
-                    addToken(&lexer->tokenList, TOKEN_COLON, buffer, startLine, startCol, 0);
+                    emitToken(lexer, TOKEN_COLON, buffer, startLine, startCol, 0);
                     advance(lexer);
                     break;
                     
@@ -422,7 +573,7 @@ void tokenize(Lexer *lexer) {
         }
     }
     
-    addToken(&lexer->tokenList, TOKEN_EOF, "EOF", lexer->lineNumber, lexer->columnNumber, 0);
+    emitToken(lexer, TOKEN_EOF, "EOF", lexer->lineNumber, lexer->columnNumber, 0);
 }
 
 void analyzeLexer(Lexer *lexer) {
@@ -5,20 +5,42 @@
 #include "symbolTable.h"
 
 #define MAX_INPUT_LEN 10000
+#define DEFAULT_WINDOW_LEN 65536
+#define MIN_WINDOW_LEN 256
+
+// Receives each completed token instead of the lexer's TokenList
+typedef void (*TokenSink)(void *context, TokenType type, const char *lexeme,
+                          int line, int col, int value);
 
 typedef struct {
-    char input[MAX_INPUT_LEN];
+    char *input;        // Whole source, or the current window when streaming
+    int length;         // Valid bytes in input
+    int capacity;       // Allocated bytes in input (excluding terminator)
+    FILE *stream;       // Refills the window when non-NULL
+    int ownsInput;      // Zero when input is borrowed from the caller
+    int stopPosition;   // No token starts at or after this offset; -1 for none
+    int quiet;          // Count errors and warnings without printing them
+    int directives;     // Lex a leading '#name' as a DIRECTIVE token
+    int lastTokenLine;  // Line the previous token ended on
+    int tokenStart;     // Offset in input where the token being emitted began
     int position;
     int lineNumber;
     int columnNumber;
     TokenList tokenList;
     SymbolTable symbolTable;
+    TokenSink tokenSink;
+    void *sinkContext;
     int errorCount;
     int warningCount;
 } Lexer;
 
 // Function declarations
 void initLexer(Lexer *lexer, const char *input);
+int initStreamLexer(Lexer *lexer, FILE *stream, int windowSize);
+void initBufferLexer(Lexer *lexer, const char *input, int length,
+                     int position, int lineNumber);
+void setTokenSink(Lexer *lexer, TokenSink sink, void *context);
+void freeLexer(Lexer *lexer);
 void tokenize(Lexer *lexer);
 char getCurrentChar(Lexer *lexer);
 char peekChar(Lexer *lexer, int offset);
@@ -30,6 +52,7 @@ void scanNumber(Lexer *lexer, char *buffer);
 void scanIdentifier(Lexer *lexer, char *buffer);
 void scanString(Lexer *lexer, char *buffer);
 void scanCharLiteral(Lexer *lexer, char *buffer);
+void scanDirective(Lexer *lexer, char *buffer);
 void skipWhitespace(Lexer *lexer);
 void skipComment(Lexer *lexer);
 void reportError(Lexer *lexer, const char *message);
@@ -1,6 +1,15 @@
 #include "lexer.h"
+#include "xref.h"
+#include "globalSymbols.h"
+#include "search.h"
+#include "include.h"
+#include "window.h"
+#include "minify.h"
+#include "source.h"
+#include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 void readInputFile(const char *filename, char *buffer, int maxLen) {
     FILE *file = fopen(filename, "r");
@@ -43,12 +52,400 @@ void writeSymbolTableToFile(SymbolTable *symbolTable, const char *filename) {
     printf("Symbol table written to: %s\n", filename);
 }
 
-int main() {
+// Token sink for streaming mode: rows are formatted a batch at a time
+void streamTokenRow(void *context, TokenType type, const char *lexeme,
+                    int line, int col, int value) {
+    (void)value;
+    addBatchToken((TokenBatch *)context, type, lexeme, line, col);
+}
+
+int runStreamMode(const char *inputFile, const char *outputFile, int windowSize) {
+    FILE *in = fopen(inputFile, "r");
+    if (in == NULL) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", inputFile);
+        return 1;
+    }
+    
+    FILE *out = fopen(outputFile, "w");
+    if (out == NULL) {
+        fprintf(stderr, "Error: Cannot create output file '%s'\n", outputFile);
+        fclose(in);
+        return 1;
+    }
+    setvbuf(out, NULL, _IOFBF, DEFAULT_WINDOW_LEN);
+    
+    TokenBatch output;
+    Lexer lexer;
+    if (!initStreamLexer(&lexer, in, windowSize)) {
+        fclose(out);
+        fclose(in);
+        return 1;
+    }
+    // Buffered rows get the same budget as the window
+    if (!initTokenBatch(&output, out, lexer.capacity)) {
+        freeLexer(&lexer);
+        fclose(out);
+        fclose(in);
+        return 1;
+    }
+    setTokenSink(&lexer, streamTokenRow, &output);
+    
+    printf("Streaming '%s' through a %d byte window...\n", inputFile, lexer.capacity);
+    printTokenHeader(out);
+    tokenize(&lexer);
+    flushTokenBatch(&output);
+    printTokenFooter(out, output.count);
+    printSymbolTable(&lexer.symbolTable, out);
+    
+    printf("Total Tokens: %ld\n", output.count);
+    printf("Symbols kept: %d (evicted: %ld)\n",
+           lexer.symbolTable.count, lexer.symbolTable.evicted);
+    printf("Errors: %d\n", lexer.errorCount);
+    printf("Tokens and symbol summary written to: %s\n", outputFile);
+    
+    freeLexer(&lexer);
+    freeTokenBatch(&output);
+    fclose(out);
+    fclose(in);
+    return lexer.errorCount > 0;
+}
+
+int runIndexMode(const char *indexFile, char *files[], int fileCount) {
+    XrefIndex index;
+    int relexed = 0;
+    int failed = 0;
+    
+    initXrefIndex(&index);
+    if (!loadXrefIndex(&index, indexFile)) {
+        freeXrefIndex(&index);
+        return 1;
+    }
+    
+    for (int i = 0; i < fileCount; i++) {
+        int result = updateXrefFile(&index, files[i]);
+        if (result < 0) {
+            failed++;
+        } else {
+            relexed += result;
+        }
+    }
+    int dropped = pruneXrefIndex(&index);
+    
+    int saved = saveXrefIndex(&index, indexFile);
+    printf("Indexed %d file(s), %d unchanged, %d removed\n",
+           relexed, fileCount - relexed - failed, dropped);
+    if (saved) {
+        printf("Cross-reference index written to: %s\n", indexFile);
+    }
+    
+    freeXrefIndex(&index);
+    return !saved || failed > 0;
+}
+
+int runQueryMode(const char *indexFile, const char *name) {
+    int found = queryXrefIndex(indexFile, name, stdout);
+    if (found < 0) {
+        return 1;
+    }
+    printf("%d use(s) of '%s'\n", found, name);
+    return 0;
+}
+
+#define MAX_LEXER_THREADS 64
+
+typedef struct {
+    GlobalSymbolTable *table;
+    char **files;
+    int fileCount;
+    int nextFile;   // Claimed atomically by the workers
+    long tokens;
+    int errors;
+} SymbolJob;
+
+void countToken(void *context, TokenType type, const char *lexeme,
+                int line, int col, int value) {
+    (void)type; (void)lexeme; (void)line; (void)col; (void)value;
+    (*(long *)context)++;
+}
+
+// Lexes files until none are left, batching symbols into the global table
+void* lexFilesWorker(void *arg) {
+    SymbolJob *job = (SymbolJob *)arg;
+    Lexer *lexer = malloc(sizeof(Lexer));
+    long tokens = 0;
+    int errors = 0;
+    
+    if (lexer == NULL) {
+        fprintf(stderr, "Error: Out of memory for a lexer\n");
+        return NULL;
+    }
+    
+    for (;;) {
+        int i = __atomic_fetch_add(&job->nextFile, 1, __ATOMIC_RELAXED);
+        if (i >= job->fileCount) {
+            break;
+        }
+        
+        FILE *in = fopen(job->files[i], "r");
+        if (in == NULL) {
+            fprintf(stderr, "Error: Cannot open file '%s'\n", job->files[i]);
+            errors++;
+            continue;
+        }
+        if (initStreamLexer(lexer, in, DEFAULT_WINDOW_LEN)) {
+            setTokenSink(lexer, countToken, &tokens);
+            setSymbolFlush(&lexer->symbolTable, mergeSymbols, job->table);
+            tokenize(lexer);
+            flushSymbolTable(&lexer->symbolTable);
+            errors += lexer->errorCount;
+            freeLexer(lexer);
+        }
+        fclose(in);
+    }
+    
+    __atomic_fetch_add(&job->tokens, tokens, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&job->errors, errors, __ATOMIC_RELAXED);
+    free(lexer);
+    return NULL;
+}
+
+int runSymbolsMode(char *files[], int fileCount, int threadCount) {
+    GlobalSymbolTable *table = malloc(sizeof(GlobalSymbolTable));
+    pthread_t threads[MAX_LEXER_THREADS];
+    SymbolJob job = { table, files, fileCount, 0, 0, 0 };
+    int started = 0;
+    
+    if (table == NULL || !initGlobalSymbolTable(table)) {
+        free(table);
+        return 1;
+    }
+    if (threadCount < 1) {
+        threadCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threadCount > fileCount) {
+        threadCount = fileCount;
+    }
+    if (threadCount > MAX_LEXER_THREADS) {
+        threadCount = MAX_LEXER_THREADS;
+    }
+    
+    printf("Lexing %d file(s) on %d thread(s)...\n", fileCount, threadCount < 1 ? 1 : threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        if (pthread_create(&threads[started], NULL, lexFilesWorker, &job) == 0) {
+            started++;
+        }
+    }
+    if (started == 0) {
+        lexFilesWorker(&job);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    printGlobalSymbolTable(table, stdout);
+    printf("Total Tokens: %ld\n", job.tokens);
+    printf("Errors: %d\n", job.errors);
+    
+    freeGlobalSymbolTable(table);
+    free(table);
+    return job.errors > 0;
+}
+
+int runSearchMode(const char *typeName, const char *pattern, char *files[], int fileCount) {
+    TokenType type;
+    long total = 0;
+    int failed = 0;
+    
+    if (!parseTokenType(typeName, &type)) {
+        fprintf(stderr, "Error: Unknown token type '%s'\n", typeName);
+        return 1;
+    }
+    
+    for (int i = 0; i < fileCount; i++) {
+        long matches = searchTokens(files[i], type, pattern, stdout);
+        if (matches < 0) {
+            failed++;
+        } else {
+            total += matches;
+        }
+    }
+    
+    printf("%ld matching %s token(s)\n", total, typeName);
+    return failed > 0;
+}
+
+int runProjectMode(char *args[], int argCount) {
+    HeaderCache cache;
+    TokenBatch output;
+    int printRows = 0;
+    int units = 0;
+    int failed = 0;
+    
+    initHeaderCache(&cache);
+    for (int i = 0; i < argCount; i++) {
+        if (strcmp(args[i], "-I") == 0 && i + 1 < argCount) {
+            if (!addIncludeDir(&cache, args[++i])) {
+                return 1;
+            }
+        } else if (strcmp(args[i], "--tokens") == 0) {
+            printRows = 1;
+        }
+    }
+    if (printRows && !initTokenBatch(&output, stdout, 0)) {
+        return 1;
+    }
+    
+    for (int i = 0; i < argCount; i++) {
+        if (strcmp(args[i], "-I") == 0) {
+            i++;
+            continue;
+        }
+        if (strcmp(args[i], "--tokens") == 0) {
+            continue;
+        }
+        
+        long tokens = 0;
+        UnitStats stats;
+        int ok;
+        
+        if (printRows) {
+            printf("\n========== %s ==========\n", args[i]);
+            printTokenHeader(stdout);
+            output.count = 0;
+            ok = expandTranslationUnit(&cache, args[i], streamTokenRow, &output, &stats);
+            flushTokenBatch(&output);
+            printTokenFooter(stdout, output.count);
+        } else {
+            ok = expandTranslationUnit(&cache, args[i], countToken, &tokens, &stats);
+        }
+        if (!ok) {
+            failed++;
+            continue;
+        }
+        
+        units++;
+        printf("%s: %ld tokens (%ld from %d header(s)), %d error(s)",
+               args[i], stats.tokens, stats.headerTokens, stats.headers, stats.errors);
+        if (stats.missing > 0) {
+            printf(", %d missing include(s)", stats.missing);
+        }
+        printf("\n");
+    }
+    
+    printf("\nTranslation units: %d\n", units);
+    printf("Headers lexed: %d (cache hits: %ld)\n", cache.headerCount, cache.hits);
+    
+    if (printRows) {
+        freeTokenBatch(&output);
+    }
+    freeHeaderCache(&cache);
+    return failed > 0;
+}
+
+int runMinifyMode(const char *inputFile, const char *outputFile) {
+    SourceFile source;
+    FILE *out = stdout;
+    
+    if (!openSourceFile(&source, inputFile)) {
+        return 1;
+    }
+    if (outputFile != NULL && (out = fopen(outputFile, "w")) == NULL) {
+        fprintf(stderr, "Error: Cannot create output file '%s'\n", outputFile);
+        closeSourceFile(&source);
+        return 1;
+    }
+    
+    long written = minifySource(source.data, source.length, out);
+    if (outputFile != NULL) {
+        fclose(out);
+        if (written >= 0) {
+            printf("Minified %ld bytes to %ld: %s\n", source.length, written, outputFile);
+        }
+    }
+    
+    closeSourceFile(&source);
+    return written < 0;
+}
+
+void printUsage(const char *program) {
+    fprintf(stderr, "Usage: %s\n", program);
+    fprintf(stderr, "       %s --stream [--window BYTES] [input] [output]\n", program);
+    fprintf(stderr, "           (token rows are buffered in about BYTES more memory)\n");
+    fprintf(stderr, "       %s --index INDEX FILE...\n", program);
+    fprintf(stderr, "       %s --query INDEX IDENTIFIER\n", program);
+    fprintf(stderr, "       %s --symbols [--threads N] FILE...\n", program);
+    fprintf(stderr, "       %s --search TOKEN_TYPE PATTERN FILE...\n", program);
+    fprintf(stderr, "       %s --project [-I DIR]... [--tokens] FILE...\n", program);
+    fprintf(stderr, "       %s --lines FIRST:LAST FILE\n", program);
+    fprintf(stderr, "       %s --minify FILE [OUTPUT]\n", program);
+}
+
+int main(int argc, char *argv[]) {
+    // Minified output may go to stdout, so it comes before the banner
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "--minify") == 0) {
+        return runMinifyMode(argv[2], argc == 4 ? argv[3] : NULL);
+    }
+    
     printf("\n╔════════════════════════════════════════════╗\n");
     printf("║   LEXICAL ANALYZER - Compiler Design       ║\n");
     printf("║   Author: Gokul-2004-cm                    ║\n");
     printf("╚════════════════════════════════════════════╝\n\n");
     
+    if (argc > 1 && strcmp(argv[1], "--stream") == 0) {
+        const char *inputFile = "input/input.txt";
+        const char *outputFile = "output/tokens.txt";
+        int windowSize = DEFAULT_WINDOW_LEN;
+        int positional = 0;
+        
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+                windowSize = atoi(argv[++i]);
+            } else if (positional == 0) {
+                inputFile = argv[i];
+                positional++;
+            } else if (positional == 1) {
+                outputFile = argv[i];
+                positional++;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        return runStreamMode(inputFile, outputFile, windowSize);
+    } else if (argc > 2 && strcmp(argv[1], "--index") == 0) {
+        return runIndexMode(argv[2], argv + 3, argc - 3);
+    } else if (argc == 4 && strcmp(argv[1], "--query") == 0) {
+        return runQueryMode(argv[2], argv[3]);
+    } else if (argc > 2 && strcmp(argv[1], "--symbols") == 0) {
+        int threadCount = 0;
+        int first = 2;
+        if (strcmp(argv[2], "--threads") == 0) {
+            if (argc <= 4) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            threadCount = atoi(argv[3]);
+            first = 4;
+        }
+        return runSymbolsMode(argv + first, argc - first, threadCount);
+    } else if (argc > 4 && strcmp(argv[1], "--search") == 0) {
+        return runSearchMode(argv[2], argv[3], argv + 4, argc - 4);
+    } else if (argc > 2 && strcmp(argv[1], "--project") == 0) {
+        return runProjectMode(argv + 2, argc - 2);
+    } else if (argc == 4 && strcmp(argv[1], "--lines") == 0) {
+        int firstLine;
+        int lastLine;
+        if (sscanf(argv[2], "%d:%d", &firstLine, &lastLine) != 2 ||
+            firstLine < 1 || lastLine < firstLine) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return printLineWindow(argv[3], firstLine, lastLine, stdout) < 0;
+    } else if (argc > 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
     Lexer lexer;
     char input[MAX_INPUT_LEN];
     
@@ -85,5 +482,6 @@ int main() {
         printf("⚠ %d warning(s) found!\n", lexer.warningCount);
     }
     
+    freeLexer(&lexer);
     return 0;
 }
\ No newline at end of file
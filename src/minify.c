@@ -0,0 +1,217 @@
+#include "minify.h"
+#include "restart.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char *data;
+    long length;
+    long written;   // Bytes handed to fp so far
+    FILE *fp;
+    int failed;
+} MinifyOutput;
+
+// Longest first: tokens are matched by maximal munch, as C does
+static const char *multiCharOperators[] = {
+    "<<=", ">>=", "...",
+    "++", "--", "->", "==", "!=", "<=", ">=", "<<", ">>", "&&", "||",
+    "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "##"
+};
+
+#define NUM_MULTI_CHAR_OPERATORS 23
+
+static void flushOutput(MinifyOutput *out) {
+    if (out->length > 0 && fwrite(out->data, 1, out->length, out->fp) != (size_t)out->length) {
+        out->failed = 1;
+    }
+    out->written += out->length;
+    out->length = 0;
+}
+
+// Copies a slice of the input; slices larger than the buffer go straight out
+static void emitSlice(MinifyOutput *out, const char *slice, long length) {
+    if (out->length + length > MINIFY_BUFFER_LEN) {
+        flushOutput(out);
+    }
+    if (length >= MINIFY_BUFFER_LEN) {
+        if (fwrite(slice, 1, length, out->fp) != (size_t)length) {
+            out->failed = 1;
+        }
+        out->written += length;
+        return;
+    }
+    memcpy(out->data + out->length, slice, length);
+    out->length += length;
+}
+
+// '$' and UTF-8 bytes are identifier characters in GCC and Clang
+static int isWordChar(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '$' || (unsigned char)c >= 0x80;
+}
+
+// Whether prev followed directly by next would lex differently
+static int needsSeparator(char prev, char next, int prevWasNumber) {
+    if (prev == '\0' || prev == '\n') {
+        return 0;
+    }
+    if (isWordChar(prev) && (isWordChar(next) || next == '"' || next == '\'')) {
+        return 1;
+    }
+    // A pp-number also takes dots, and a sign after e, E, p or P, so
+    // "0x1E + 5" must not become "0x1E+5"
+    if (prevWasNumber && (isWordChar(next) || next == '.' ||
+                          ((next == '+' || next == '-') && strchr("eEpP", prev) != NULL))) {
+        return 1;
+    }
+    if (prev == '.' && isdigit((unsigned char)next)) {
+        return 1;
+    }
+    switch (prev) {
+        case '+': return next == '+' || next == '=';
+        case '-': return next == '-' || next == '=' || next == '>';
+        case '*': return next == '=';
+        case '/': return next == '/' || next == '*' || next == '=';
+        case '%': return next == '=';
+        case '=': return next == '=';
+        case '!': return next == '=';
+        case '<': return next == '<' || next == '=';
+        case '>': return next == '>' || next == '=';
+        case '&': return next == '&' || next == '=';
+        case '|': return next == '|' || next == '=';
+        case '^': return next == '=';
+        case '#': return next == '#';
+        case '.': return next == '.';
+        default: return 0;
+    }
+}
+
+// Length of the token at i that is not a comment, literal or whitespace
+static long tokenLength(const char *input, long length, long i) {
+    long j = i;
+    char c = input[i];
+    
+    // Preprocessing numbers, so 0x1F, 1e-5 and 10UL stay whole
+    if (isdigit((unsigned char)c) ||
+        (c == '.' && i + 1 < length && isdigit((unsigned char)input[i + 1]))) {
+        j++;
+        while (j < length && (isWordChar(input[j]) || input[j] == '.' ||
+               ((input[j] == '+' || input[j] == '-') && strchr("eEpP", input[j - 1]) != NULL))) {
+            j++;
+        }
+        return j - i;
+    }
+    if (isWordChar(c)) {
+        while (j < length && isWordChar(input[j])) {
+            j++;
+        }
+        return j - i;
+    }
+    for (int k = 0; k < NUM_MULTI_CHAR_OPERATORS; k++) {
+        long opLen = strlen(multiCharOperators[k]);
+        if (i + opLen <= length && memcmp(input + i, multiCharOperators[k], opLen) == 0) {
+            return opLen;
+        }
+    }
+    return 1;
+}
+
+// Writes input with comments dropped and whitespace reduced to what keeps
+// tokens apart. Token text is copied straight from input; no lexemes or
+// token table are built. Directives keep their own lines. Returns the bytes
+// written, or -1 on error.
+long minifySource(const char *input, long length, FILE *fp) {
+    MinifyOutput out = { malloc(MINIFY_BUFFER_LEN), 0, 0, fp, 0 };
+    char prev = '\0';           // Last byte written
+    int prevWasNumber = 0;
+    int lineStart = 1;          // Nothing but whitespace so far on this line
+    int inDirective = 0;
+    int directiveTokens = 0;    // Tokens so far in the current directive
+    int isDefine = 0;
+    long prevEnd = -1;          // Input offset just past the last token written
+    long i = 0;
+    
+    if (out.data == NULL) {
+        fprintf(stderr, "Error: Out of memory for the output buffer\n");
+        return -1;
+    }
+    
+    while (i < length) {
+        char c = input[i];
+        
+        if (c == '\n') {
+            if (inDirective) {
+                emitSlice(&out, "\n", 1);
+                prev = '\n';
+                inDirective = 0;
+            }
+            lineStart = 1;
+            i++;
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') {
+            i++;
+            continue;
+        }
+        // A spliced line continues the directive
+        if (c == '\\' && inDirective && i + 1 < length &&
+            (input[i + 1] == '\n' || input[i + 1] == '\r')) {
+            i += input[i + 1] == '\r' && i + 2 < length && input[i + 2] == '\n' ? 3 : 2;
+            continue;
+        }
+        
+        long end = skipConstruct(input, length, i);
+        if (end > i && c == '/') {
+            // Comments vanish; a line comment leaves its newline, and a block
+            // comment that spans lines outside a directive starts a new one
+            if (!inDirective && memchr(input + i, '\n', end - i) != NULL) {
+                lineStart = 1;
+            }
+            i = end;
+            continue;
+        }
+        
+        long tokenLen = end > i ? end - i : tokenLength(input, length, i);
+        if (c == '#' && lineStart) {
+            if (prev != '\0' && prev != '\n') {
+                emitSlice(&out, "\n", 1);
+                prev = '\n';
+            }
+            inDirective = 1;
+            directiveTokens = 0;
+            isDefine = 0;
+        } else if (i > prevEnd && needsSeparator(prev, c, prevWasNumber)) {
+            // Only a gap in the source can need a separator
+            emitSlice(&out, " ", 1);
+        } else if (i > prevEnd && isDefine && directiveTokens == 3) {
+            // An object-like macro's name needs whitespace after it, and
+            // "#define X (1)" must not become a function-like macro
+            emitSlice(&out, " ", 1);
+        }
+        
+        emitSlice(&out, input + i, tokenLen);
+        prev = input[i + tokenLen - 1];
+        prevWasNumber = isdigit((unsigned char)c) || (c == '.' && tokenLen > 1);
+        lineStart = 0;
+        i += tokenLen;
+        prevEnd = i;
+        if (inDirective) {
+            directiveTokens++;
+            if (directiveTokens == 2) {
+                isDefine = tokenLen == 6 && memcmp(input + i - 6, "define", 6) == 0;
+            }
+        }
+    }
+    
+    if (prev != '\0' && prev != '\n') {
+        emitSlice(&out, "\n", 1);
+    }
+    flushOutput(&out);
+    free(out.data);
+    
+    if (out.failed) {
+        fprintf(stderr, "Error: Cannot write minified output\n");
+        return -1;
+    }
+    return out.written;
+}
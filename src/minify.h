@@ -0,0 +1,11 @@
+#ifndef MINIFY_H
+#define MINIFY_H
+
+#include <stdio.h>
+
+#define MINIFY_BUFFER_LEN (1 << 20)
+
+// Function declarations
+long minifySource(const char *input, long length, FILE *fp);
+
+#endif
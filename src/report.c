@@ -0,0 +1,172 @@
+#include "report.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/uio.h>
+
+typedef struct {
+    const void *rows;
+    int first;
+    int last;
+    RowFormatter format;
+    char *buffer;
+    size_t length;
+} ReportChunk;
+
+// Same bytes as "%-*s": text followed by spaces up to width
+char* appendPadded(char *out, const char *text, int width) {
+    int len = strlen(text);
+    memcpy(out, text, len);
+    out += len;
+    while (len < width) {
+        *out++ = ' ';
+        len++;
+    }
+    return out;
+}
+
+// Same bytes as "%-*ld"
+char* appendPaddedInt(char *out, long value, int width) {
+    char digits[MAX_INT_TEXT_LEN];
+    int len = 0;
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+    
+    do {
+        digits[len++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    
+    int written = len;
+    if (value < 0) {
+        *out++ = '-';
+        written++;
+    }
+    while (len > 0) {
+        *out++ = digits[--len];
+    }
+    while (written < width) {
+        *out++ = ' ';
+        written++;
+    }
+    return out;
+}
+
+static void* formatChunk(void *arg) {
+    ReportChunk *chunk = (ReportChunk *)arg;
+    char *out = chunk->buffer;
+    for (int i = chunk->first; i < chunk->last; i++) {
+        out = chunk->format(chunk->rows, i, out);
+    }
+    chunk->length = out - chunk->buffer;
+    return NULL;
+}
+
+static int countWorkers(int count) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = (count + ROWS_PER_WORKER - 1) / ROWS_PER_WORKER;
+    
+    if (cores < 1) {
+        cores = 1;
+    }
+    if (workers > cores) {
+        workers = cores;
+    }
+    if (workers > MAX_REPORT_WORKERS) {
+        workers = MAX_REPORT_WORKERS;
+    }
+    return workers < 1 ? 1 : workers;
+}
+
+static int writeChunks(int fd, ReportChunk *chunks, int workers) {
+    struct iovec iov[MAX_REPORT_WORKERS];
+    int first = 0;
+    
+    for (int i = 0; i < workers; i++) {
+        iov[i].iov_base = chunks[i].buffer;
+        iov[i].iov_len = chunks[i].length;
+    }
+    
+    while (first < workers) {
+        ssize_t written = writev(fd, iov + first, workers - first);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+        // Skip fully written buffers and trim a partially written one
+        while (first < workers && (size_t)written >= iov[first].iov_len) {
+            written -= iov[first].iov_len;
+            first++;
+        }
+        if (first < workers) {
+            iov[first].iov_base = (char *)iov[first].iov_base + written;
+            iov[first].iov_len -= written;
+        }
+    }
+    return 1;
+}
+
+// Formats rows in parallel ranges and writes them in order with one writev.
+// Falls back to formatting on the calling thread when threads or memory are short.
+void writeReportRows(FILE *fp, const void *rows, int count, int maxRowLen,
+                     RowFormatter format) {
+    ReportChunk chunks[MAX_REPORT_WORKERS];
+    pthread_t threads[MAX_REPORT_WORKERS];
+    int started[MAX_REPORT_WORKERS];
+    int workers = countWorkers(count);
+    int perWorker = (count + workers - 1) / workers;
+    int ok = 1;
+    
+    if (count <= 0) {
+        return;
+    }
+    
+    for (int i = 0; i < workers; i++) {
+        chunks[i].rows = rows;
+        chunks[i].first = i * perWorker < count ? i * perWorker : count;
+        chunks[i].last = chunks[i].first + perWorker < count ? chunks[i].first + perWorker : count;
+        chunks[i].format = format;
+        chunks[i].length = 0;
+        chunks[i].buffer = malloc((size_t)(chunks[i].last - chunks[i].first) * maxRowLen + 1);
+        if (chunks[i].buffer == NULL) {
+            ok = 0;
+        }
+    }
+    
+    for (int i = 0; i < workers; i++) {
+        started[i] = ok && i > 0 &&
+                     pthread_create(&threads[i], NULL, formatChunk, &chunks[i]) == 0;
+    }
+    for (int i = 0; i < workers && ok; i++) {
+        if (!started[i]) {
+            // Worker 0 and any thread that failed to start run here
+            formatChunk(&chunks[i]);
+        }
+    }
+    for (int i = 0; i < workers; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+    
+    if (ok) {
+        fflush(fp);
+        if (!writeChunks(fileno(fp), chunks, workers)) {
+            fprintf(stderr, "Error: Cannot write report rows\n");
+        }
+    } else {
+        fprintf(stderr, "Warning: Out of memory for report buffers, using stdio\n");
+        for (int i = 0; i < count; i++) {
+            char row[maxRowLen + 1];
+            char *end = format(rows, i, row);
+            fwrite(row, 1, end - row, fp);
+        }
+    }
+    
+    for (int i = 0; i < workers; i++) {
+        free(chunks[i].buffer);
+    }
+}
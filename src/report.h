@@ -0,0 +1,19 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <stdio.h>
+
+#define MAX_REPORT_WORKERS 16
+#define ROWS_PER_WORKER 2048
+#define MAX_INT_TEXT_LEN 24
+
+// Formats row `index` of `rows` at out and returns the end of what was written
+typedef char* (*RowFormatter)(const void *rows, int index, char *out);
+
+// Function declarations
+char* appendPadded(char *out, const char *text, int width);
+char* appendPaddedInt(char *out, long value, int width);
+void writeReportRows(FILE *fp, const void *rows, int count, int maxRowLen,
+                     RowFormatter format);
+
+#endif
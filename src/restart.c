@@ -0,0 +1,249 @@
+#include "restart.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static int countNewlines(const char *input, long from, long to) {
+    int lines = 0;
+    const char *p = input + from;
+    const char *end = input + to;
+    while (p < end && (p = memchr(p, '\n', end - p)) != NULL) {
+        lines++;
+        p++;
+    }
+    return lines;
+}
+
+// Offset just past a construct starting at i, mirroring skipComment,
+// scanString and scanCharLiteral; i itself when input[i] starts none
+long skipConstruct(const char *input, long length, long i) {
+    long j = i + 1;
+    
+    if (input[i] == '/' && j < length && input[j] == '/') {
+        // The newline is left for the caller, like skipComment does
+        const char *newline = memchr(input + j, '\n', length - j);
+        return newline != NULL ? newline - input : length;
+    }
+    if (input[i] == '/' && j < length && input[j] == '*') {
+        const char *p = input + i + 2;
+        const char *end = input + length;
+        while (p + 1 < end && (p = memchr(p, '*', end - 1 - p)) != NULL) {
+            if (p[1] == '/') {
+                return p + 2 - input;
+            }
+            p++;
+        }
+        return length;
+    }
+    if (input[i] == '"') {
+        while (j < length && input[j] != '"') {
+            j += input[j] == '\\' ? 2 : 1;
+        }
+        return j < length ? j + 1 : length;
+    }
+    if (input[i] == '\'') {
+        j += j < length && input[j] == '\\' ? 2 : 1;
+        if (j < length && input[j] == '\'') {
+            j++;
+        }
+        return j < length ? j : length;
+    }
+    return i;
+}
+
+void initScanCursor(ScanCursor *cursor) {
+    cursor->offset = 0;
+    cursor->lineNumber = 1;
+    cursor->lastSafe.offset = 0;
+    cursor->lastSafe.lineNumber = 1;
+}
+
+// Scans up to target, recording every line start reached in code as a
+// restart point. May stop past target when a comment or literal crosses it.
+// With SSE2, plain code is taken 16 bytes at a time: its newlines are only
+// counted, and the last one becomes the restart point.
+void advanceScanCursor(ScanCursor *cursor, const char *input, long length, long target) {
+    long i = cursor->offset;
+    int line = cursor->lineNumber;
+    
+    if (target > length) {
+        target = length;
+    }
+    
+#ifdef __SSE2__
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i doubleQuote = _mm_set1_epi8('"');
+    const __m128i singleQuote = _mm_set1_epi8('\'');
+#endif
+
+    while (i < target) {
+#ifdef __SSE2__
+        if (i + 16 <= target) {
+            __m128i block = _mm_loadu_si128((const __m128i *)(input + i));
+            unsigned lines = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+            unsigned openers = _mm_movemask_epi8(
+                _mm_or_si128(_mm_cmpeq_epi8(block, slash),
+                             _mm_or_si128(_mm_cmpeq_epi8(block, doubleQuote),
+                                          _mm_cmpeq_epi8(block, singleQuote))));
+            // Only bytes before the first possible comment or literal are plain
+            int plain = openers != 0 ? __builtin_ctz(openers) : 16;
+            lines &= (1u << plain) - 1;
+            if (lines != 0) {
+                cursor->lastSafe.offset = i + 32 - __builtin_clz(lines);
+                for (; lines != 0; lines &= lines - 1) {
+                    line++;
+                }
+                cursor->lastSafe.lineNumber = line;
+            }
+            i += plain;
+            if (plain == 16) {
+                continue;
+            }
+        }
+#endif
+        char c = input[i];
+        if (c == '\n') {
+            i++;
+            line++;
+            cursor->lastSafe.offset = i;
+            cursor->lastSafe.lineNumber = line;
+        } else if (c == '/' || c == '"' || c == '\'') {
+            long end = skipConstruct(input, length, i);
+            if (end == i) {
+                i++;
+            } else {
+                line += countNewlines(input, i, end);
+                i = end;
+            }
+        } else {
+            i++;
+        }
+    }
+    
+    cursor->offset = i;
+    cursor->lineNumber = line;
+}
+
+void initRestartIndex(RestartIndex *index) {
+    index->points = NULL;
+    index->count = 0;
+    index->capacity = 0;
+    index->size = 0;
+    index->modified = 0;
+    index->length = 0;
+}
+
+void freeRestartIndex(RestartIndex *index) {
+    free(index->points);
+    initRestartIndex(index);
+}
+
+static int addRestartPoint(RestartIndex *index, long offset, int lineNumber) {
+    if (index->count == index->capacity) {
+        int capacity = index->capacity ? index->capacity * 2 : 64;
+        RestartPoint *points = realloc(index->points, capacity * sizeof(RestartPoint));
+        if (points == NULL) {
+            return 0;
+        }
+        index->points = points;
+        index->capacity = capacity;
+    }
+    index->points[index->count].offset = offset;
+    index->points[index->count].lineNumber = lineNumber;
+    index->count++;
+    return 1;
+}
+
+// One pass over input: the latest restart point before each interval boundary.
+// The start of the file is always the first point.
+int buildRestartIndex(RestartIndex *index, const char *input, long length, long interval) {
+    ScanCursor cursor;
+    
+    index->count = 0;
+    index->length = length;
+    initScanCursor(&cursor);
+    if (!addRestartPoint(index, 0, 1)) {
+        return 0;
+    }
+    
+    for (long boundary = interval; boundary < length; boundary += interval) {
+        advanceScanCursor(&cursor, input, length, boundary);
+        RestartPoint *last = &index->points[index->count - 1];
+        if (cursor.lastSafe.offset > last->offset &&
+            !addRestartPoint(index, cursor.lastSafe.offset, cursor.lastSafe.lineNumber)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Reads an index written by saveRestartIndex. Returns 0 when it is missing,
+// unreadable, or was built for a different size or mtime than the caller set.
+int loadRestartIndex(RestartIndex *index, const char *indexPath) {
+    FILE *file = fopen(indexPath, "r");
+    char magic[16];
+    long long size;
+    long long modified;
+    long long length;
+    int count;
+    
+    if (file == NULL) {
+        return 0;
+    }
+    if (fscanf(file, "%15s %lld %lld %lld %d", magic, &size, &modified, &length, &count) != 5 ||
+        strcmp(magic, RESTART_INDEX_MAGIC) != 0 || size != index->size ||
+        modified != index->modified || length < 0 || length > size || count < 1) {
+        fclose(file);
+        return 0;
+    }
+    
+    index->length = length;
+    index->count = 0;
+    for (int i = 0; i < count; i++) {
+        long offset;
+        int lineNumber;
+        if (fscanf(file, "%ld %d", &offset, &lineNumber) != 2 ||
+            offset < 0 || offset > length || !addRestartPoint(index, offset, lineNumber)) {
+            index->count = 0;
+            fclose(file);
+            return 0;
+        }
+    }
+    fclose(file);
+    return 1;
+}
+
+int saveRestartIndex(const RestartIndex *index, const char *indexPath) {
+    FILE *file = fopen(indexPath, "w");
+    if (file == NULL) {
+        return 0;
+    }
+    
+    fprintf(file, "%s %lld %lld %lld %d\n", RESTART_INDEX_MAGIC,
+            index->size, index->modified, index->length, index->count);
+    for (int i = 0; i < index->count; i++) {
+        fprintf(file, "%ld %d\n", index->points[i].offset, index->points[i].lineNumber);
+    }
+    return fclose(file) == 0;
+}
+
+// Latest restart point on or before lineNumber
+RestartPoint findRestartPoint(const RestartIndex *index, int lineNumber) {
+    int low = 0;
+    int high = index->count - 1;
+    
+    while (low < high) {
+        int mid = (low + high + 1) / 2;
+        if (index->points[mid].lineNumber <= lineNumber) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return index->points[low];
+}
@@ -0,0 +1,46 @@
+#ifndef RESTART_H
+#define RESTART_H
+
+#define RESTART_INTERVAL 65536
+#define RESTART_INDEX_SUFFIX ".rsi"
+#define RESTART_INDEX_MAGIC "LXRSI2"
+
+// A line start where the lexer is between tokens: lexing can begin here
+// with only the line number known
+typedef struct {
+    long offset;
+    int lineNumber;
+} RestartPoint;
+
+// Follows comments and literals the way tokenize() does, without building
+// tokens. Comments and literals are skipped whole, so the cursor is always
+// between tokens.
+typedef struct {
+    long offset;            // Everything before offset has been scanned
+    int lineNumber;         // Line at offset
+    RestartPoint lastSafe;  // Latest restart point at or before the last target
+} ScanCursor;
+
+// Restart points roughly every RESTART_INTERVAL bytes, kept beside the
+// source as text and rebuilt when the source's size or mtime changes
+typedef struct {
+    RestartPoint *points;
+    int count;
+    int capacity;
+    long long size;
+    long long modified;     // Nanoseconds since the epoch
+    long long length;       // Bytes before the first NUL, where lexing ends
+} RestartIndex;
+
+// Function declarations
+long skipConstruct(const char *input, long length, long i);
+void initScanCursor(ScanCursor *cursor);
+void advanceScanCursor(ScanCursor *cursor, const char *input, long length, long target);
+void initRestartIndex(RestartIndex *index);
+void freeRestartIndex(RestartIndex *index);
+int buildRestartIndex(RestartIndex *index, const char *input, long length, long interval);
+int loadRestartIndex(RestartIndex *index, const char *indexPath);
+int saveRestartIndex(const RestartIndex *index, const char *indexPath);
+RestartPoint findRestartPoint(const RestartIndex *index, int lineNumber);
+
+#endif
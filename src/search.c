@@ -0,0 +1,183 @@
+#include "search.h"
+#include "lexer.h"
+#include "restart.h"
+#include "source.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+typedef struct {
+    const char *path;
+    TokenType type;
+    const char *pattern;
+    long patternLen;
+    const char *source;     // The buffer the lexer reads, for full token text
+    const Lexer *lexer;
+    FILE *fp;
+    int lastLine;   // Position of the last printed match; windows may overlap
+    int lastColumn;
+    long matches;
+} SearchSink;
+
+// Offset of the first occurrence of needle, or -1. With SSE2, 16 candidate
+// positions are tested at once against the needle's first and last bytes
+// and only positions matching both are compared in full.
+long findSubstring(const char *haystack, long length, const char *needle, long needleLen) {
+    long i = 0;
+    
+    if (needleLen <= 0) {
+        return 0;
+    }
+    
+#ifdef __SSE2__
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[needleLen - 1]);
+    for (; i + needleLen - 1 + 16 <= length; i += 16) {
+        __m128i blockFirst = _mm_loadu_si128((const __m128i *)(haystack + i));
+        __m128i blockLast = _mm_loadu_si128((const __m128i *)(haystack + i + needleLen - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, blockFirst),
+                                                        _mm_cmpeq_epi8(last, blockLast)));
+        while (mask != 0) {
+            int bit = __builtin_ctz(mask);
+            if (memcmp(haystack + i + bit, needle, needleLen) == 0) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    while (i + needleLen <= length) {
+        const char *p = memchr(haystack + i, needle[0], length - needleLen + 1 - i);
+        if (p == NULL) {
+            return -1;
+        }
+        i = p - haystack;
+        if (memcmp(p, needle, needleLen) == 0) {
+            return i;
+        }
+        i++;
+    }
+    return -1;
+}
+
+// Lexemes stop at MAX_LEXEME_LEN - 1 bytes, so a token that long is
+// matched against its full text in the source instead
+static int tokenContains(const SearchSink *sink, const char *lexeme) {
+    if (strlen(lexeme) < MAX_LEXEME_LEN - 1) {
+        return strstr(lexeme, sink->pattern) != NULL;
+    }
+    const Lexer *lexer = sink->lexer;
+    const char *text = sink->source + lexer->tokenStart;
+    long length = lexer->position - lexer->tokenStart;
+    
+    // A directive's lexeme is "#name", without the blanks the source may
+    // have after the '#', so a leading '#' in pattern anchors it to the name
+    if (sink->type == TOKEN_DIRECTIVE) {
+        text++;
+        length--;
+        while (length > 0 && (*text == ' ' || *text == '\t')) {
+            text++;
+            length--;
+        }
+        if (sink->pattern[0] == '#') {
+            long restLen = sink->patternLen - 1;
+            return restLen <= length && memcmp(text, sink->pattern + 1, restLen) == 0;
+        }
+    }
+    return findSubstring(text, length, sink->pattern, sink->patternLen) >= 0;
+}
+
+// The bytes to look for in the source. Directive lexemes drop the blanks
+// after the '#', so "#include" is found by its name, which "#  include"
+// also contains, and only lines with a '#' are lexed for a bare "#".
+static const char* sourcePattern(TokenType type, const char *pattern) {
+    if (type != TOKEN_DIRECTIVE) {
+        return pattern;
+    }
+    const char *name = pattern;
+    if (*name == '#') {
+        name++;
+    }
+    while (*name == ' ' || *name == '\t') {
+        name++;
+    }
+    return *name != '\0' ? name : "#";
+}
+
+static void printMatch(void *context, TokenType type, const char *lexeme,
+                       int line, int col, int value) {
+    SearchSink *sink = (SearchSink *)context;
+    (void)value;
+    
+    if (type != sink->type || !tokenContains(sink, lexeme)) {
+        return;
+    }
+    if (line < sink->lastLine || (line == sink->lastLine && col <= sink->lastColumn)) {
+        return;
+    }
+    
+    fprintf(sink->fp, "%s:%d:%d: %s %s\n", sink->path, line, col,
+            getTokenTypeString(type), lexeme);
+    sink->lastLine = line;
+    sink->lastColumn = col;
+    sink->matches++;
+}
+
+// Prints every token of the given type whose lexeme contains pattern.
+// Only the lines around raw substring hits are lexed, each from the nearest
+// restart point before the hit. Returns the match count, or -1 on error.
+long searchTokens(const char *path, TokenType type, const char *pattern, FILE *fp) {
+    SourceFile source;
+    if (!openSourceFile(&source, path)) {
+        return -1;
+    }
+    
+    long patternLen = strlen(pattern);
+    const char *filter = sourcePattern(type, pattern);
+    long filterLen = strlen(filter);
+    ScanCursor cursor;
+    Lexer *lexer = malloc(sizeof(Lexer));
+    SearchSink sink = { path, type, pattern, patternLen, source.data, lexer, fp, 0, 0, 0 };
+    long from = 0;
+    
+    if (lexer == NULL) {
+        fprintf(stderr, "Error: Out of memory for a lexer\n");
+        closeSourceFile(&source);
+        return -1;
+    }
+    initScanCursor(&cursor);
+    
+    while (from < source.length) {
+        long hit = findSubstring(source.data + from, source.length - from, filter, filterLen);
+        if (hit < 0) {
+            break;
+        }
+        hit += from;
+        
+        // Lex from the restart point through the end of the hit's last line
+        advanceScanCursor(&cursor, source.data, source.length, hit);
+        long lastByte = hit + (filterLen > 0 ? filterLen - 1 : 0);
+        const char *newline = memchr(source.data + lastByte, '\n', source.length - lastByte);
+        long stop = newline != NULL ? newline - source.data + 1 : source.length;
+        if (filterLen == 0) {
+            stop = source.length;
+        }
+        
+        initBufferLexer(lexer, source.data, (int)source.length,
+                        (int)cursor.lastSafe.offset, cursor.lastSafe.lineNumber);
+        lexer->stopPosition = (int)stop;
+        lexer->quiet = 1;
+        lexer->directives = type == TOKEN_DIRECTIVE;
+        setTokenSink(lexer, printMatch, &sink);
+        tokenize(lexer);
+        
+        from = lexer->position > hit ? lexer->position : hit + 1;
+        freeLexer(lexer);
+    }
+    
+    free(lexer);
+    closeSourceFile(&source);
+    return sink.matches;
+}
@@ -0,0 +1,11 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdio.h>
+#include "token.h"
+
+// Function declarations
+long findSubstring(const char *haystack, long length, const char *needle, long needleLen);
+long searchTokens(const char *path, TokenType type, const char *pattern, FILE *fp);
+
+#endif
@@ -0,0 +1,83 @@
+#include "source.h"
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Maps path without looking for a NUL, so length is the whole file and no
+// page is touched yet. The caller must find where the lexable text ends.
+int mapSourceFile(SourceFile *source, const char *path) {
+    struct stat info;
+    int fd = open(path, O_RDONLY);
+    
+    source->data = "";
+    source->length = 0;
+    source->mappedLength = 0;
+    
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 0;
+    }
+    // Lexer offsets are ints
+    if (info.st_size >= INT_MAX) {
+        fprintf(stderr, "Error: File '%s' is too large to lex\n", path);
+        close(fd);
+        return 0;
+    }
+    if (info.st_size == 0) {
+        close(fd);
+        return 1;
+    }
+    
+    void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Error: Cannot map file '%s'\n", path);
+        return 0;
+    }
+    source->data = data;
+    source->mappedLength = info.st_size;
+    source->length = info.st_size;
+    return 1;
+}
+
+int openSourceFile(SourceFile *source, const char *path) {
+    if (!mapSourceFile(source, path)) {
+        return 0;
+    }
+    
+    // tokenize() treats NUL as end of input, so nothing past it is source
+    const char *nul = memchr(source->data, '\0', source->mappedLength);
+    if (nul != NULL) {
+        source->length = nul - source->data;
+    }
+    return 1;
+}
+
+void closeSourceFile(SourceFile *source) {
+    if (source->mappedLength > 0) {
+        munmap((void *)source->data, source->mappedLength);
+    }
+    source->data = "";
+    source->length = 0;
+    source->mappedLength = 0;
+}
+
+// Reads the size and modification time of path, in nanoseconds so that an
+// edit within the same second still looks like a change. Returns 0 if path
+// cannot be read.
+int statSourceFile(const char *path, long long *modified, long long *size) {
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        return 0;
+    }
+    *modified = (long long)info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+    *size = (long long)info.st_size;
+    return 1;
+}
@@ -0,0 +1,17 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+// A whole source file mapped read-only into memory
+typedef struct {
+    const char *data;
+    long length;        // Bytes the lexer will see: up to the first NUL
+    long mappedLength;
+} SourceFile;
+
+// Function declarations
+int openSourceFile(SourceFile *source, const char *path);
+int mapSourceFile(SourceFile *source, const char *path);
+void closeSourceFile(SourceFile *source);
+int statSourceFile(const char *path, long long *modified, long long *size);
+
+#endif
@@ -1,32 +1,174 @@
 #include "symbolTable.h"
+#include "report.h"
+
+// Longest row formatSymbolRow can produce
+#define SYMBOL_ROW_LEN (MAX_SYMBOL_LEN + 3 + 15 + 3 + MAX_SYMBOL_LEN + \
+                        3 * (3 + MAX_INT_TEXT_LEN) + 1)
 
 void initSymbolTable(SymbolTable *table) {
     table->count = 0;
+    table->bounded = 0;
+    table->evicted = 0;
+    table->flush = NULL;
+    table->flushContext = NULL;
+    memset(table->index, 0xff, sizeof(table->index));
 }
 
-int isDuplicate(SymbolTable *table, const char *name, int scope) {
-    for (int i = 0; i < table->count; i++) {
-        if (strcmp(table->symbols[i].name, name) == 0 && 
-            table->symbols[i].scope == scope) {
-            return 1;
+// Turns the table into a local buffer that hands batches to flush when full
+void setSymbolFlush(SymbolTable *table, SymbolFlush flush, void *context) {
+    table->bounded = 0;
+    table->flush = flush;
+    table->flushContext = context;
+}
+
+void flushSymbolTable(SymbolTable *table) {
+    if (table->flush != NULL && table->count > 0) {
+        table->flush(table->flushContext, table->symbols, table->count);
+    }
+    table->count = 0;
+    memset(table->index, 0xff, sizeof(table->index));
+}
+
+static unsigned long hashName(const char *name) {
+    unsigned long hash = 2166136261UL;
+    while (*name) {
+        hash = (hash ^ (unsigned char)*name++) * 16777619UL;
+    }
+    return hash & (SYMBOL_INDEX_SLOTS - 1);
+}
+
+// Returns the first symbol called name, in scope too if matchScope is set
+static Symbol* findSymbol(SymbolTable *table, const char *name, int scope, int matchScope) {
+    unsigned long slot = hashName(name);
+    while (table->index[slot] != NO_SYMBOL) {
+        Symbol *sym = &table->symbols[table->index[slot]];
+        if (strcmp(sym->name, name) == 0 && (!matchScope || sym->scope == scope)) {
+            return sym;
+        }
+        slot = (slot + 1) & (SYMBOL_INDEX_SLOTS - 1);
+    }
+    return NULL;
+}
+
+static void indexSymbol(SymbolTable *table, int i) {
+    unsigned long slot = hashName(table->symbols[i].name);
+    while (table->index[slot] != NO_SYMBOL) {
+        slot = (slot + 1) & (SYMBOL_INDEX_SLOTS - 1);
+    }
+    table->index[slot] = i;
+}
+
+// Removes symbol i from the index, shifting the rest of its probe run back
+// so later lookups do not stop at the hole
+static void unindexSymbol(SymbolTable *table, int i) {
+    unsigned long mask = SYMBOL_INDEX_SLOTS - 1;
+    unsigned long hole = hashName(table->symbols[i].name);
+    while (table->index[hole] != i) {
+        hole = (hole + 1) & mask;
+    }
+    for (unsigned long next = (hole + 1) & mask; table->index[next] != NO_SYMBOL;
+         next = (next + 1) & mask) {
+        unsigned long home = hashName(table->symbols[table->index[next]].name);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            table->index[hole] = table->index[next];
+            hole = next;
         }
     }
-    return 0;
+    table->index[hole] = NO_SYMBOL;
+}
+
+static void swapHeap(SymbolTable *table, int a, int b) {
+    short sym = table->heap[a];
+    table->heap[a] = table->heap[b];
+    table->heap[b] = sym;
+    table->heapPos[table->heap[a]] = a;
+    table->heapPos[table->heap[b]] = b;
+}
+
+static int heapUsage(SymbolTable *table, int pos) {
+    return table->symbols[table->heap[pos]].usage;
+}
+
+static void siftUp(SymbolTable *table, int pos) {
+    while (pos > 0 && heapUsage(table, (pos - 1) / 2) > heapUsage(table, pos)) {
+        swapHeap(table, pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+}
+
+static void siftDown(SymbolTable *table, int pos) {
+    for (;;) {
+        int least = pos;
+        int left = 2 * pos + 1;
+        if (left < table->count && heapUsage(table, left) < heapUsage(table, least)) {
+            least = left;
+        }
+        if (left + 1 < table->count && heapUsage(table, left + 1) < heapUsage(table, least)) {
+            least = left + 1;
+        }
+        if (least == pos) {
+            return;
+        }
+        swapHeap(table, pos, least);
+        pos = least;
+    }
+}
+
+static void countUse(SymbolTable *table, Symbol *sym) {
+    sym->usage++;
+    if (table->bounded) {
+        siftDown(table, table->heapPos[sym - table->symbols]);
+    }
+}
+
+int isDuplicate(SymbolTable *table, const char *name, int scope) {
+    return findSymbol(table, name, scope, 1) != NULL;
+}
+
+// Space-saving eviction: the newcomer takes over the least used slot, found
+// at the top of the heap, and inherits its usage, so usage in a bounded
+// table is an upper bound.
+static Symbol* evictLeastUsed(SymbolTable *table) {
+    Symbol *victim = &table->symbols[table->heap[0]];
+    unindexSymbol(table, table->heap[0]);
+    table->evicted++;
+    return victim;
 }
 
 int addSymbol(SymbolTable *table, const char *name, SymbolType type,
               const char *dataType, int scope, int lineNumber) {
-    if (table->count >= MAX_SYMBOLS) {
+    if (table->bounded || table->flush != NULL) {
+        // A summary or batch counts repeats instead of warning about each one
+        Symbol *existing = findSymbol(table, name, scope, 1);
+        if (existing != NULL) {
+            countUse(table, existing);
+            return 0;
+        }
+    }
+    
+    if (table->count >= MAX_SYMBOLS && table->flush != NULL) {
+        flushSymbolTable(table);
+    } else if (table->count >= MAX_SYMBOLS && !table->bounded) {
         fprintf(stderr, "Error: Symbol table overflow\n");
         return 0;
     }
     
-    if (isDuplicate(table, name, scope)) {
+    if (!table->bounded && table->flush == NULL && isDuplicate(table, name, scope)) {
         fprintf(stderr, "Warning: Duplicate symbol '%s' at line %d\n", name, lineNumber);
         return 0;
     }
     
-    Symbol *sym = &table->symbols[table->count];
+    Symbol *sym;
+    int inheritedUsage = 0;
+    int evicting = table->count >= MAX_SYMBOLS;
+    if (evicting) {
+        sym = evictLeastUsed(table);
+        inheritedUsage = sym->usage;
+    } else {
+        sym = &table->symbols[table->count];
+        table->count++;
+    }
+    
     strncpy(sym->name, name, MAX_SYMBOL_LEN - 1);
     sym->name[MAX_SYMBOL_LEN - 1] = '\0';
     sym->type = type;
@@ -34,25 +176,28 @@ int addSymbol(SymbolTable *table, const char *name, SymbolType type,
     sym->dataType[MAX_SYMBOL_LEN - 1] = '\0';
     sym->scope = scope;
     sym->lineNumber = lineNumber;
-    sym->usage = 0;
+    sym->usage = inheritedUsage;
+    
+    int i = sym - table->symbols;
+    indexSymbol(table, i);
+    // An evicted slot keeps its usage and so its place in the heap
+    if (table->bounded && !evicting) {
+        table->heap[i] = i;
+        table->heapPos[i] = i;
+        siftUp(table, i);
+    }
     
-    table->count++;
     return 1;
 }
 
 Symbol* lookupSymbol(SymbolTable *table, const char *name) {
-    for (int i = 0; i < table->count; i++) {
-        if (strcmp(table->symbols[i].name, name) == 0) {
-            return &table->symbols[i];
-        }
-    }
-    return NULL;
+    return findSymbol(table, name, 0, 0);
 }
 
 void updateSymbolUsage(SymbolTable *table, const char *name) {
     Symbol *sym = lookupSymbol(table, name);
     if (sym != NULL) {
-        sym->usage++;
+        countUse(table, sym);
     }
 }
 
@@ -67,23 +212,40 @@ const char* getSymbolTypeString(SymbolType type) {
     }
 }
 
-void printSymbolTable(SymbolTable *table, FILE *fp) {
+// Hand-rolled equivalent of "%-20s | %-15s | %-12s | %-6d | %-6d | %-6d\n"
+static char* formatSymbolRow(const void *rows, int index, char *out) {
+    const Symbol *sym = &((const Symbol *)rows)[index];
+    out = appendPadded(out, sym->name, 20);
+    out = appendPadded(out, " | ", 0);
+    out = appendPadded(out, getSymbolTypeString(sym->type), 15);
+    out = appendPadded(out, " | ", 0);
+    out = appendPadded(out, sym->dataType, 12);
+    out = appendPadded(out, " | ", 0);
+    out = appendPaddedInt(out, sym->scope, 6);
+    out = appendPadded(out, " | ", 0);
+    out = appendPaddedInt(out, sym->lineNumber, 6);
+    out = appendPadded(out, " | ", 0);
+    out = appendPaddedInt(out, sym->usage, 6);
+    *out++ = '\n';
+    return out;
+}
+
+void printSymbolList(const Symbol *symbols, int count, FILE *fp) {
     fprintf(fp, "\n=================================================================\n");
     fprintf(fp, "%-20s | %-15s | %-12s | %-6s | %-6s | %-6s\n",
             "Symbol Name", "Symbol Type", "Data Type", "Scope", "Line", "Usage");
     fprintf(fp, "=================================================================\n");
     
-    for (int i = 0; i < table->count; i++) {
-        Symbol *sym = &table->symbols[i];
-        fprintf(fp, "%-20s | %-15s | %-12s | %-6d | %-6d | %-6d\n",
-                sym->name,
-                getSymbolTypeString(sym->type),
-                sym->dataType,
-                sym->scope,
-                sym->lineNumber,
-                sym->usage);
-    }
+    writeReportRows(fp, symbols, count, SYMBOL_ROW_LEN, formatSymbolRow);
     
     fprintf(fp, "=================================================================\n");
-    fprintf(fp, "Total Symbols: %d\n\n", table->count);
+    fprintf(fp, "Total Symbols: %d\n", count);
+}
+
+void printSymbolTable(SymbolTable *table, FILE *fp) {
+    printSymbolList(table->symbols, table->count, fp);
+    if (table->evicted > 0) {
+        fprintf(fp, "Evicted Symbols: %ld (usage counts are upper bounds)\n", table->evicted);
+    }
+    fprintf(fp, "\n");
 }
\ No newline at end of file
@@ -7,6 +7,8 @@
 
 #define MAX_SYMBOLS 500
 #define MAX_SYMBOL_LEN 100
+#define SYMBOL_INDEX_SLOTS 1024     // Power of two, at least twice MAX_SYMBOLS
+#define NO_SYMBOL -1
 
 typedef enum {
     SYMBOL_VARIABLE, SYMBOL_FUNCTION, SYMBOL_KEYWORD, SYMBOL_ARRAY, SYMBOL_STRUCT
@@ -21,9 +23,19 @@ typedef struct {
     int usage;  // Number of times used
 } Symbol;
 
+// Receives a full batch of symbols before the table is emptied
+typedef void (*SymbolFlush)(void *context, const Symbol *symbols, int count);
+
 typedef struct {
     Symbol symbols[MAX_SYMBOLS];
     int count;
+    int bounded;    // When full, evict the least used symbol instead of failing
+    long evicted;   // Symbols dropped from a bounded table
+    SymbolFlush flush;      // When set, a full table is flushed instead of failing
+    void *flushContext;
+    short index[SYMBOL_INDEX_SLOTS];    // Open-addressed by name, NO_SYMBOL if empty
+    short heap[MAX_SYMBOLS];            // Bounded tables: min-heap of symbols by usage
+    short heapPos[MAX_SYMBOLS];         // Where each symbol sits in heap
 } SymbolTable;
 
 // Function declarations
@@ -32,6 +44,9 @@ int addSymbol(SymbolTable *table, const char *name, SymbolType type,
               const char *dataType, int scope, int lineNumber);
 Symbol* lookupSymbol(SymbolTable *table, const char *name);
 void updateSymbolUsage(SymbolTable *table, const char *name);
+void setSymbolFlush(SymbolTable *table, SymbolFlush flush, void *context);
+void flushSymbolTable(SymbolTable *table);
+void printSymbolList(const Symbol *symbols, int count, FILE *fp);
 void printSymbolTable(SymbolTable *table, FILE *fp);
 int isDuplicate(SymbolTable *table, const char *name, int scope);
 
@@ -8,6 +8,7 @@
 #define MAX_TOKENS 1000
 #define MAX_LEXEME_LEN 100
 #define MAX_TOKEN_LEN 50
+#define TOKEN_BATCH_LEN 16384
 
 typedef enum {
     // Keywords
@@ -28,6 +29,9 @@ typedef enum {
     TOKEN_LBRACKET, TOKEN_RBRACKET, TOKEN_SEMICOLON, TOKEN_COMMA, TOKEN_DOT,
     TOKEN_COLON, TOKEN_ARROW,
     
+    // Preprocessor
+    TOKEN_DIRECTIVE,
+    
     // Special
     TOKEN_EOF, TOKEN_ERROR, TOKEN_UNKNOWN
 } TokenType;
@@ -45,11 +49,29 @@ typedef struct {
     int count;
 } TokenList;
 
+// Buffers rows for long token reports so each batch is formatted in
+// parallel and written at once
+typedef struct {
+    FILE *fp;
+    long count;         // Rows added so far, including pending ones
+    int pending;        // Rows waiting in tokens
+    int capacity;       // At most TOKEN_BATCH_LEN
+    Token *tokens;
+} TokenBatch;
+
 // Function declarations
 void initTokenList(TokenList *list);
 void addToken(TokenList *list, TokenType type, const char *lexeme, 
               int line, int col, int value);
 void printTokens(TokenList *list, FILE *fp);
+void printTokenHeader(FILE *fp);
+int initTokenBatch(TokenBatch *batch, FILE *fp, long budget);
+void addBatchToken(TokenBatch *batch, TokenType type, const char *lexeme,
+                   int line, int col);
+void flushTokenBatch(TokenBatch *batch);
+void freeTokenBatch(TokenBatch *batch);
+void printTokenFooter(FILE *fp, long count);
 const char* getTokenTypeString(TokenType type);
+int parseTokenType(const char *name, TokenType *type);
 
 #endif
\ No newline at end of file
@@ -1,4 +1,9 @@
 #include "token.h"
+#include "report.h"
+
+// Longest row formatTokenRow can produce
+#define TOKEN_ROW_LEN (MAX_INT_TEXT_LEN + 3 + 20 + 3 + MAX_LEXEME_LEN + 3 + \
+                       MAX_INT_TEXT_LEN + 3 + MAX_INT_TEXT_LEN + 1)
 
 void initTokenList(TokenList *list) {
     list->count = 0;
@@ -80,6 +85,9 @@ const char* getTokenTypeString(TokenType type) {
         case TOKEN_COLON: return "COLON";
         case TOKEN_ARROW: return "ARROW";
         
+        // Preprocessor
+        case TOKEN_DIRECTIVE: return "DIRECTIVE";
+        
         case TOKEN_EOF: return "EOF";
         case TOKEN_ERROR: return "ERROR";
         case TOKEN_UNKNOWN: return "UNKNOWN";
@@ -88,22 +96,111 @@ const char* getTokenTypeString(TokenType type) {
     }
 }
 
-void printTokens(TokenList *list, FILE *fp) {
+// Reverse of getTokenTypeString, e.g. "STRING" or "IDENTIFIER"
+int parseTokenType(const char *name, TokenType *type) {
+    for (int i = 0; i <= TOKEN_UNKNOWN; i++) {
+        if (strcmp(name, getTokenTypeString((TokenType)i)) == 0) {
+            *type = (TokenType)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void printTokenHeader(FILE *fp) {
     fprintf(fp, "=================================================\n");
     fprintf(fp, "%-5s | %-20s | %-15s | %-8s | %-8s\n",
             "No.", "Token Type", "Lexeme", "Line", "Column");
     fprintf(fp, "=================================================\n");
+}
+
+// Hand-rolled equivalent of "%-5ld | %-20s | %-15s | %-8d | %-8d\n"
+static char* formatTokenRow(char *out, long number, TokenType type,
+                            const char *lexeme, int line, int col) {
+    out = appendPaddedInt(out, number, 5);
+    out = appendPadded(out, " | ", 0);
+    out = appendPadded(out, getTokenTypeString(type), 20);
+    out = appendPadded(out, " | ", 0);
+    out = appendPadded(out, lexeme, 15);
+    out = appendPadded(out, " | ", 0);
+    out = appendPaddedInt(out, line, 8);
+    out = appendPadded(out, " | ", 0);
+    out = appendPaddedInt(out, col, 8);
+    *out++ = '\n';
+    return out;
+}
+
+static char* formatTokenListRow(const void *rows, int index, char *out) {
+    const Token *token = &((const Token *)rows)[index];
+    return formatTokenRow(out, index + 1, token->type, token->lexeme,
+                          token->lineNumber, token->columnNumber);
+}
+
+static char* formatTokenBatchRow(const void *rows, int index, char *out) {
+    const TokenBatch *batch = (const TokenBatch *)rows;
+    const Token *token = &batch->tokens[index];
+    return formatTokenRow(out, batch->count - batch->pending + index + 1, token->type,
+                          token->lexeme, token->lineNumber, token->columnNumber);
+}
+
+// budget caps the bytes held by buffered rows and their formatted text,
+// so a batch can stay within a stream's window; 0 means TOKEN_BATCH_LEN rows
+int initTokenBatch(TokenBatch *batch, FILE *fp, long budget) {
+    long capacity = budget > 0 ? budget / (long)(sizeof(Token) + TOKEN_ROW_LEN) : TOKEN_BATCH_LEN;
+    if (capacity < 1) {
+        capacity = 1;
+    }
+    if (capacity > TOKEN_BATCH_LEN) {
+        capacity = TOKEN_BATCH_LEN;
+    }
     
-    for (int i = 0; i < list->count; i++) {
-        Token *token = &list->tokens[i];
-        fprintf(fp, "%-5d | %-20s | %-15s | %-8d | %-8d\n",
-                i + 1,
-                getTokenTypeString(token->type),
-                token->lexeme,
-                token->lineNumber,
-                token->columnNumber);
+    batch->fp = fp;
+    batch->count = 0;
+    batch->pending = 0;
+    batch->capacity = (int)capacity;
+    batch->tokens = malloc(capacity * sizeof(Token));
+    if (batch->tokens == NULL) {
+        fprintf(stderr, "Error: Out of memory for %ld token rows\n", capacity);
+        return 0;
+    }
+    return 1;
+}
+
+void addBatchToken(TokenBatch *batch, TokenType type, const char *lexeme,
+                   int line, int col) {
+    if (batch->pending == batch->capacity) {
+        flushTokenBatch(batch);
     }
     
+    Token *token = &batch->tokens[batch->pending++];
+    token->type = type;
+    strncpy(token->lexeme, lexeme, MAX_LEXEME_LEN - 1);
+    token->lexeme[MAX_LEXEME_LEN - 1] = '\0';
+    token->lineNumber = line;
+    token->columnNumber = col;
+    token->tokenValue = 0;
+    batch->count++;
+}
+
+void flushTokenBatch(TokenBatch *batch) {
+    writeReportRows(batch->fp, batch, batch->pending, TOKEN_ROW_LEN, formatTokenBatchRow);
+    batch->pending = 0;
+}
+
+void freeTokenBatch(TokenBatch *batch) {
+    free(batch->tokens);
+    batch->tokens = NULL;
+}
+
+void printTokenFooter(FILE *fp, long count) {
     fprintf(fp, "=================================================\n");
-    fprintf(fp, "Total Tokens: %d\n", list->count);
+    fprintf(fp, "Total Tokens: %ld\n", count);
+}
+
+void printTokens(TokenList *list, FILE *fp) {
+    printTokenHeader(fp);
+    
+    writeReportRows(fp, list->tokens, list->count, TOKEN_ROW_LEN, formatTokenListRow);
+    
+    printTokenFooter(fp, list->count);
 }
\ No newline at end of file
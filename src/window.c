@@ -0,0 +1,110 @@
+#include "window.h"
+#include "lexer.h"
+#include "restart.h"
+#include "source.h"
+
+typedef struct {
+    TokenBatch rows;
+    int firstLine;
+    int lastLine;
+} WindowSink;
+
+static void printWindowToken(void *context, TokenType type, const char *lexeme,
+                             int line, int col, int value) {
+    WindowSink *sink = (WindowSink *)context;
+    (void)value;
+    
+    if (line < sink->firstLine || line > sink->lastLine) {
+        return;
+    }
+    addBatchToken(&sink->rows, type, lexeme, line, col);
+}
+
+// Loads the restart index stored beside path, rebuilding it if it is
+// missing or was built for another version of the file. The index also
+// records where the first NUL is, so a fresh index spares a scan of the
+// whole file; source->length is set from it.
+static int prepareRestartIndex(RestartIndex *index, const char *path, SourceFile *source) {
+    char indexPath[4096];
+    
+    if (!statSourceFile(path, &index->modified, &index->size)) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", path);
+        return 0;
+    }
+    snprintf(indexPath, sizeof(indexPath), "%s%s", path, RESTART_INDEX_SUFFIX);
+    
+    if (loadRestartIndex(index, indexPath) && index->length <= source->mappedLength) {
+        source->length = index->length;
+        return 1;
+    }
+    
+    const char *nul = memchr(source->data, '\0', source->mappedLength);
+    source->length = nul != NULL ? nul - source->data : source->mappedLength;
+    if (!buildRestartIndex(index, source->data, source->length, RESTART_INTERVAL)) {
+        fprintf(stderr, "Error: Out of memory indexing '%s'\n", path);
+        return 0;
+    }
+    if (!saveRestartIndex(index, indexPath)) {
+        fprintf(stderr, "Warning: Cannot write restart index '%s'\n", indexPath);
+    }
+    return 1;
+}
+
+// Prints the tokens that start on lines firstLine..lastLine, lexing only
+// from the nearest restart point. Returns the token count, or -1 on error.
+long printLineWindow(const char *path, int firstLine, int lastLine, FILE *fp) {
+    SourceFile source;
+    RestartIndex index;
+    
+    if (!mapSourceFile(&source, path)) {
+        return -1;
+    }
+    initRestartIndex(&index);
+    if (!prepareRestartIndex(&index, path, &source)) {
+        closeSourceFile(&source);
+        return -1;
+    }
+    
+    RestartPoint start = findRestartPoint(&index, firstLine);
+    freeRestartIndex(&index);
+    
+    // No token may start past the end of lastLine
+    const char *p = source.data + start.offset;
+    const char *end = source.data + source.length;
+    for (int line = start.lineNumber; line <= lastLine && p < end; line++) {
+        const char *newline = memchr(p, '\n', end - p);
+        p = newline != NULL ? newline + 1 : end;
+    }
+    
+    Lexer *lexer = malloc(sizeof(Lexer));
+    WindowSink sink = { { NULL, 0, 0, 0, NULL }, firstLine, lastLine };
+    if (lexer == NULL) {
+        fprintf(stderr, "Error: Out of memory for a lexer\n");
+        closeSourceFile(&source);
+        return -1;
+    }
+    if (!initTokenBatch(&sink.rows, fp, 0)) {
+        free(lexer);
+        closeSourceFile(&source);
+        return -1;
+    }
+    
+    fprintf(fp, "Lines %d-%d of %s (lexed from line %d, byte %ld)\n",
+            firstLine, lastLine, path, start.lineNumber, start.offset);
+    printTokenHeader(fp);
+    initBufferLexer(lexer, source.data, (int)source.length,
+                    (int)start.offset, start.lineNumber);
+    lexer->stopPosition = (int)(p - source.data);
+    lexer->quiet = 1;
+    setTokenSink(lexer, printWindowToken, &sink);
+    tokenize(lexer);
+    flushTokenBatch(&sink.rows);
+    printTokenFooter(fp, sink.rows.count);
+    
+    long count = sink.rows.count;
+    freeTokenBatch(&sink.rows);
+    freeLexer(lexer);
+    free(lexer);
+    closeSourceFile(&source);
+    return count;
+}
@@ -0,0 +1,9 @@
+#ifndef WINDOW_H
+#define WINDOW_H
+
+#include <stdio.h>
+
+// Function declarations
+long printLineWindow(const char *path, int firstLine, int lastLine, FILE *fp);
+
+#endif
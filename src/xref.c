@@ -0,0 +1,801 @@
+#include "xref.h"
+#include "lexer.h"
+#include "source.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*
+ * Index file layout:
+ *   magic | fileCount nameCount filesLen namesLen postingsLen
+ *         | files:     { pathLen path modified size }*
+ *         | names:     { nameLen name postingOffset postingLen postingCount }*
+ *         | nameTable: nameCount offsets into names, in name order
+ *         | postings
+ * The five counts and the nameTable offsets are 8-byte little-endian so a
+ * query can binary-search the table in place; everything else is a LEB128
+ * varint. A posting list holds (fileDelta, line, column) triples ordered by
+ * file and position. line is a delta from the previous entry when fileDelta
+ * is 0.
+ */
+
+// Longest names entry: a name and four varints
+#define XREF_MAX_ENTRY_LEN (MAX_LEXEME_LEN + 4 * 10)
+
+// Where each section of an index file starts, checked against its size
+typedef struct {
+    unsigned long long fileCount;
+    unsigned long long nameCount;
+    unsigned long long filesLen;
+    unsigned long long namesLen;
+    unsigned long long postingsLen;
+    unsigned long long filesStart;
+    unsigned long long namesStart;
+    unsigned long long tableStart;
+    unsigned long long postingsStart;
+} XrefLayout;
+
+typedef struct {
+    unsigned char *data;
+    size_t length;
+    size_t capacity;
+} ByteBuffer;
+
+typedef struct {
+    const unsigned char *data;
+    size_t length;
+    size_t position;
+    int failed;
+} ByteReader;
+
+static int appendByte(ByteBuffer *buffer, unsigned char byte) {
+    if (buffer->length == buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+        unsigned char *data = realloc(buffer->data, capacity);
+        if (data == NULL) {
+            return 0;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    buffer->data[buffer->length++] = byte;
+    return 1;
+}
+
+static int appendVarint(ByteBuffer *buffer, unsigned long long value) {
+    while (value >= 0x80) {
+        if (!appendByte(buffer, (unsigned char)(value | 0x80))) {
+            return 0;
+        }
+        value >>= 7;
+    }
+    return appendByte(buffer, (unsigned char)value);
+}
+
+static int appendBytes(ByteBuffer *buffer, const char *bytes, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (!appendByte(buffer, (unsigned char)bytes[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int appendFixed(ByteBuffer *buffer, unsigned long long value) {
+    for (int i = 0; i < 8; i++) {
+        if (!appendByte(buffer, (unsigned char)(value >> (8 * i)))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static unsigned long long decodeFixed(const unsigned char *bytes) {
+    unsigned long long value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+static unsigned long long readVarint(ByteReader *reader) {
+    unsigned long long value = 0;
+    int shift = 0;
+    while (reader->position < reader->length && shift < 64) {
+        unsigned char byte = reader->data[reader->position++];
+        value |= (unsigned long long)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+        shift += 7;
+    }
+    reader->failed = 1;
+    return 0;
+}
+
+static const char* readBytes(ByteReader *reader, size_t length) {
+    if (reader->length - reader->position < length) {
+        reader->failed = 1;
+        return NULL;
+    }
+    const char *bytes = (const char *)reader->data + reader->position;
+    reader->position += length;
+    return bytes;
+}
+
+// Returns NULL with errno set when path cannot be read
+static unsigned char* readWholeFile(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    
+    struct stat info;
+    if (fstat(fileno(file), &info) != 0) {
+        int error = errno;
+        fclose(file);
+        errno = error;
+        return NULL;
+    }
+    
+    unsigned char *data = malloc(info.st_size + 1);
+    if (data != NULL) {
+        *length = fread(data, 1, info.st_size, file);
+    }
+    fclose(file);
+    if (data == NULL) {
+        errno = ENOMEM;
+    }
+    return data;
+}
+
+// Reads exactly length bytes at offset; returns 0 on error or a short file
+static int readAt(int fd, unsigned long long offset, void *buffer, size_t length) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t got = pread(fd, (char *)buffer + done, length - done, (off_t)(offset + done));
+        if (got <= 0) {
+            return 0;
+        }
+        done += got;
+    }
+    return 1;
+}
+
+// Decodes the fixed header and checks that its sections exactly fill a
+// file of fileSize bytes, so no count can run past the data
+static int parseLayout(const unsigned char *header, unsigned long long fileSize,
+                       XrefLayout *layout) {
+    const unsigned char *counts = header + XREF_MAGIC_LEN;
+    layout->fileCount = decodeFixed(counts);
+    layout->nameCount = decodeFixed(counts + 8);
+    layout->filesLen = decodeFixed(counts + 16);
+    layout->namesLen = decodeFixed(counts + 24);
+    layout->postingsLen = decodeFixed(counts + 32);
+    
+    // Every entry takes at least one byte, which also bounds allocations
+    if (layout->filesLen > fileSize || layout->namesLen > fileSize ||
+        layout->postingsLen > fileSize || layout->fileCount > layout->filesLen ||
+        layout->nameCount > layout->namesLen ||
+        layout->fileCount >= SIZE_MAX / sizeof(size_t)) {
+        return 0;
+    }
+    layout->filesStart = XREF_HEADER_LEN;
+    layout->namesStart = layout->filesStart + layout->filesLen;
+    layout->tableStart = layout->namesStart + layout->namesLen;
+    layout->postingsStart = layout->tableStart + layout->nameCount * 8;
+    return layout->postingsStart + layout->postingsLen == fileSize;
+}
+
+static unsigned long hashName(const char *name) {
+    unsigned long hash = 2166136261UL;
+    while (*name) {
+        hash = (hash ^ (unsigned char)*name++) * 16777619UL;
+    }
+    return hash;
+}
+
+void initXrefIndex(XrefIndex *index) {
+    memset(index, 0, sizeof(*index));
+}
+
+void freeXrefIndex(XrefIndex *index) {
+    for (int i = 0; i < index->nameCount; i++) {
+        free(index->names[i]);
+    }
+    for (int i = 0; i < index->fileCount; i++) {
+        free(index->files[i].path);
+        free(index->files[i].occurrences);
+    }
+    free(index->names);
+    free(index->slots);
+    free(index->files);
+    initXrefIndex(index);
+}
+
+static int growSlots(XrefIndex *index) {
+    int slotCount = index->slotCount ? index->slotCount * 2 : 1024;
+    int *slots = malloc(slotCount * sizeof(int));
+    if (slots == NULL) {
+        return 0;
+    }
+    for (int i = 0; i < slotCount; i++) {
+        slots[i] = -1;
+    }
+    for (int id = 0; id < index->nameCount; id++) {
+        unsigned long slot = hashName(index->names[id]) & (slotCount - 1);
+        while (slots[slot] != -1) {
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        slots[slot] = id;
+    }
+    free(index->slots);
+    index->slots = slots;
+    index->slotCount = slotCount;
+    return 1;
+}
+
+// Returns the id of name, adding it on first sight; -1 when out of memory
+static int internName(XrefIndex *index, const char *name) {
+    if ((index->nameCount + 1) * 2 > index->slotCount && !growSlots(index)) {
+        return -1;
+    }
+    
+    unsigned long slot = hashName(name) & (index->slotCount - 1);
+    while (index->slots[slot] != -1) {
+        if (strcmp(index->names[index->slots[slot]], name) == 0) {
+            return index->slots[slot];
+        }
+        slot = (slot + 1) & (index->slotCount - 1);
+    }
+    
+    if (index->nameCount == index->nameCapacity) {
+        int capacity = index->nameCapacity ? index->nameCapacity * 2 : 256;
+        char **names = realloc(index->names, capacity * sizeof(char *));
+        if (names == NULL) {
+            return -1;
+        }
+        index->names = names;
+        index->nameCapacity = capacity;
+    }
+    
+    size_t length = strlen(name);
+    char *copy = malloc(length + 1);
+    if (copy == NULL) {
+        return -1;
+    }
+    memcpy(copy, name, length + 1);
+    
+    index->names[index->nameCount] = copy;
+    index->slots[slot] = index->nameCount;
+    return index->nameCount++;
+}
+
+static XrefFile* findFile(XrefIndex *index, const char *path) {
+    for (int i = 0; i < index->fileCount; i++) {
+        if (index->files[i].path != NULL && strcmp(index->files[i].path, path) == 0) {
+            return &index->files[i];
+        }
+    }
+    return NULL;
+}
+
+static XrefFile* addFile(XrefIndex *index, const char *path, size_t pathLen) {
+    if (index->fileCount == index->fileCapacity) {
+        int capacity = index->fileCapacity ? index->fileCapacity * 2 : 64;
+        XrefFile *files = realloc(index->files, capacity * sizeof(XrefFile));
+        if (files == NULL) {
+            return NULL;
+        }
+        index->files = files;
+        index->fileCapacity = capacity;
+    }
+    
+    XrefFile *file = &index->files[index->fileCount];
+    memset(file, 0, sizeof(*file));
+    file->path = malloc(pathLen + 1);
+    if (file->path == NULL) {
+        return NULL;
+    }
+    memcpy(file->path, path, pathLen);
+    file->path[pathLen] = '\0';
+    index->fileCount++;
+    return file;
+}
+
+static int addOccurrence(XrefFile *file, int symbol, int line, int column) {
+    if (file->count == file->capacity) {
+        int capacity = file->capacity ? file->capacity * 2 : 256;
+        XrefOccurrence *occurrences = realloc(file->occurrences,
+                                              capacity * sizeof(XrefOccurrence));
+        if (occurrences == NULL) {
+            return 0;
+        }
+        file->occurrences = occurrences;
+        file->capacity = capacity;
+    }
+    
+    XrefOccurrence *occurrence = &file->occurrences[file->count++];
+    occurrence->symbol = symbol;
+    occurrence->line = line;
+    occurrence->column = column;
+    return 1;
+}
+
+// Returns 1 on success, 0 if the file exists but cannot be read or is not
+// a valid index. A missing index file is an empty index.
+int loadXrefIndex(XrefIndex *index, const char *indexPath) {
+    size_t length = 0;
+    unsigned char *data = readWholeFile(indexPath, &length);
+    if (data == NULL && errno == ENOENT) {
+        return 1;
+    }
+    if (data == NULL) {
+        fprintf(stderr, "Error: Cannot read cross-reference index '%s': %s\n",
+                indexPath, strerror(errno));
+        return 0;
+    }
+    
+    if (length < XREF_HEADER_LEN || memcmp(data, XREF_MAGIC, XREF_MAGIC_LEN) != 0) {
+        fprintf(stderr, "Error: '%s' is not a cross-reference index\n", indexPath);
+        free(data);
+        return 0;
+    }
+    
+    XrefLayout layout;
+    ByteReader reader = { data, 0, 0, 0 };
+    if (parseLayout(data, length, &layout)) {
+        reader.length = layout.namesStart;
+        reader.position = layout.filesStart;
+    } else {
+        reader.failed = 1;
+    }
+    
+    for (unsigned long long i = 0; i < layout.fileCount && !reader.failed; i++) {
+        size_t pathLen = readVarint(&reader);
+        const char *path = readBytes(&reader, pathLen);
+        if (path == NULL) {
+            break;
+        }
+        XrefFile *file = addFile(index, path, pathLen);
+        if (file == NULL) {
+            reader.failed = 1;
+            break;
+        }
+        file->modified = (long long)readVarint(&reader);
+        file->size = (long long)readVarint(&reader);
+    }
+    
+    if (!reader.failed) {
+        reader.length = layout.tableStart;
+        reader.position = layout.namesStart;
+    }
+    for (unsigned long long i = 0; i < layout.nameCount && !reader.failed; i++) {
+        size_t nameLen = readVarint(&reader);
+        const char *bytes = readBytes(&reader, nameLen);
+        unsigned long long offset = readVarint(&reader);
+        unsigned long long postingLen = readVarint(&reader);
+        unsigned long long postingCount = readVarint(&reader);
+        if (bytes == NULL || nameLen >= MAX_LEXEME_LEN || offset > layout.postingsLen ||
+            postingLen > layout.postingsLen - offset) {
+            reader.failed = 1;
+            break;
+        }
+        
+        char name[MAX_LEXEME_LEN];
+        memcpy(name, bytes, nameLen);
+        name[nameLen] = '\0';
+        int symbol = internName(index, name);
+        
+        ByteReader postings = { data + layout.postingsStart + offset, postingLen, 0, 0 };
+        unsigned long long fileId = 0;
+        int line = 0;
+        for (unsigned long long p = 0; p < postingCount && !postings.failed; p++) {
+            unsigned long long fileDelta = readVarint(&postings);
+            unsigned long long lineValue = readVarint(&postings);
+            int column = (int)readVarint(&postings);
+            fileId += fileDelta;
+            line = fileDelta > 0 || p == 0 ? (int)lineValue : line + (int)lineValue;
+            if (symbol < 0 || fileId >= (unsigned long long)index->fileCount ||
+                !addOccurrence(&index->files[fileId], symbol, line, column)) {
+                postings.failed = 1;
+            }
+        }
+        reader.failed = postings.failed;
+    }
+    
+    free(data);
+    if (reader.failed) {
+        fprintf(stderr, "Error: Cross-reference index '%s' is corrupt\n", indexPath);
+        return 0;
+    }
+    return 1;
+}
+
+typedef struct {
+    XrefIndex *index;
+    XrefFile *file;
+    int failed;
+} XrefSink;
+
+static void collectIdentifier(void *context, TokenType type, const char *lexeme,
+                              int line, int col, int value) {
+    XrefSink *sink = (XrefSink *)context;
+    (void)value;
+    if (type != TOKEN_ID || sink->failed) {
+        return;
+    }
+    
+    int symbol = internName(sink->index, lexeme);
+    if (symbol < 0 || !addOccurrence(sink->file, symbol, line, col)) {
+        sink->failed = 1;
+    }
+}
+
+// Re-lexes path if it is new or changed since it was indexed. Files are
+// keyed by canonical path, so the index means the same from any directory.
+// The file's postings and metadata are only replaced once the whole file
+// has lexed. Returns 1 when re-indexed, 0 when unchanged and -1 on error.
+int updateXrefFile(XrefIndex *index, const char *path) {
+    char canonical[PATH_MAX];
+    long long modified;
+    long long size;
+    
+    if (realpath(path, canonical) == NULL ||
+        !statSourceFile(canonical, &modified, &size)) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", path);
+        return -1;
+    }
+    XrefFile *file = findFile(index, canonical);
+    if (file != NULL && file->modified == modified && file->size == size) {
+        return 0;
+    }
+    
+    FILE *in = fopen(canonical, "r");
+    if (in == NULL) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", path);
+        return -1;
+    }
+    
+    Lexer lexer;
+    XrefFile fresh;
+    XrefSink sink = { index, &fresh, 0 };
+    memset(&fresh, 0, sizeof(fresh));
+    if (!initStreamLexer(&lexer, in, DEFAULT_WINDOW_LEN)) {
+        fclose(in);
+        return -1;
+    }
+    setTokenSink(&lexer, collectIdentifier, &sink);
+    tokenize(&lexer);
+    freeLexer(&lexer);
+    int readFailed = ferror(in);
+    fclose(in);
+    
+    if (readFailed) {
+        fprintf(stderr, "Error: Cannot read file '%s'\n", path);
+        free(fresh.occurrences);
+        return -1;
+    }
+    if (!sink.failed && file == NULL) {
+        file = addFile(index, canonical, strlen(canonical));
+        sink.failed = file == NULL;
+    }
+    if (sink.failed) {
+        fprintf(stderr, "Error: Out of memory indexing '%s'\n", path);
+        free(fresh.occurrences);
+        return -1;
+    }
+    
+    free(file->occurrences);
+    file->occurrences = fresh.occurrences;
+    file->count = fresh.count;
+    file->capacity = fresh.capacity;
+    file->modified = modified;
+    file->size = size;
+    return 1;
+}
+
+// Drops indexed files that no longer exist; returns how many were dropped
+int pruneXrefIndex(XrefIndex *index) {
+    int dropped = 0;
+    for (int i = 0; i < index->fileCount; i++) {
+        struct stat info;
+        XrefFile *file = &index->files[i];
+        if (file->path != NULL && stat(file->path, &info) != 0) {
+            free(file->path);
+            file->path = NULL;
+            file->count = 0;
+            dropped++;
+        }
+    }
+    return dropped;
+}
+
+static int compareNames(const void *a, const void *b) {
+    return strcmp(**(char * const * const *)a, **(char * const * const *)b);
+}
+
+int saveXrefIndex(XrefIndex *index, const char *indexPath) {
+    ByteBuffer header = { NULL, 0, 0 };
+    ByteBuffer files = { NULL, 0, 0 };
+    ByteBuffer names = { NULL, 0, 0 };
+    ByteBuffer table = { NULL, 0, 0 };
+    ByteBuffer postings = { NULL, 0, 0 };
+    int *fileIds = malloc((index->fileCount + 1) * sizeof(int));
+    int *counts = calloc(index->nameCount + 1, sizeof(int));
+    int *starts = malloc((index->nameCount + 1) * sizeof(int));
+    char ***order = malloc((index->nameCount + 1) * sizeof(char **));
+    XrefOccurrence *grouped = NULL;
+    int *groupedFiles = NULL;
+    int keptFiles = 0;
+    long total = 0;
+    int ok = fileIds != NULL && counts != NULL && starts != NULL && order != NULL;
+    
+    // Renumber the surviving files and count postings per name
+    for (int i = 0; ok && i < index->fileCount; i++) {
+        XrefFile *file = &index->files[i];
+        fileIds[i] = file->path != NULL ? keptFiles++ : -1;
+        if (file->path == NULL) {
+            continue;
+        }
+        for (int j = 0; j < file->count; j++) {
+            counts[file->occurrences[j].symbol]++;
+        }
+        total += file->count;
+    }
+    
+    // Counting sort groups occurrences by name, keeping file and position order
+    if (ok) {
+        grouped = malloc((total + 1) * sizeof(XrefOccurrence));
+        groupedFiles = malloc((total + 1) * sizeof(int));
+        ok = grouped != NULL && groupedFiles != NULL;
+    }
+    for (int id = 0, next = 0; ok && id < index->nameCount; id++) {
+        starts[id] = next;
+        next += counts[id];
+        order[id] = &index->names[id];
+    }
+    for (int i = 0; ok && i < index->fileCount; i++) {
+        XrefFile *file = &index->files[i];
+        for (int j = 0; file->path != NULL && j < file->count; j++) {
+            int slot = starts[file->occurrences[j].symbol]++;
+            grouped[slot] = file->occurrences[j];
+            groupedFiles[slot] = fileIds[i];
+        }
+    }
+    
+    for (int i = 0; ok && i < index->fileCount; i++) {
+        XrefFile *file = &index->files[i];
+        if (file->path == NULL) {
+            continue;
+        }
+        size_t pathLen = strlen(file->path);
+        ok = appendVarint(&files, pathLen) &&
+             appendBytes(&files, file->path, pathLen) &&
+             appendVarint(&files, (unsigned long long)file->modified) &&
+             appendVarint(&files, (unsigned long long)file->size);
+    }
+    
+    if (ok) {
+        qsort(order, index->nameCount, sizeof(char **), compareNames);
+    }
+    int written = 0;
+    for (int i = 0; ok && i < index->nameCount; i++) {
+        int id = (int)(order[i] - index->names);
+        if (counts[id] == 0) {
+            continue;
+        }
+        
+        int first = starts[id] - counts[id];
+        int prevFile = 0;
+        int prevLine = 0;
+        size_t postingOffset = postings.length;
+        for (int p = first; ok && p < starts[id]; p++) {
+            int fileDelta = groupedFiles[p] - prevFile;
+            int line = grouped[p].line;
+            ok = appendVarint(&postings, fileDelta) &&
+                 appendVarint(&postings, fileDelta > 0 || p == first ? line : line - prevLine) &&
+                 appendVarint(&postings, grouped[p].column);
+            prevFile = groupedFiles[p];
+            prevLine = line;
+        }
+        
+        size_t nameLen = strlen(index->names[id]);
+        ok = ok && appendFixed(&table, names.length) &&
+             appendVarint(&names, nameLen) &&
+             appendBytes(&names, index->names[id], nameLen) &&
+             appendVarint(&names, postingOffset) &&
+             appendVarint(&names, postings.length - postingOffset) &&
+             appendVarint(&names, counts[id]);
+        written++;
+    }
+    ok = ok && appendBytes(&header, XREF_MAGIC, XREF_MAGIC_LEN) &&
+         appendFixed(&header, keptFiles) &&
+         appendFixed(&header, written) &&
+         appendFixed(&header, files.length) &&
+         appendFixed(&header, names.length) &&
+         appendFixed(&header, postings.length);
+         
+    // Write beside the index and rename so readers never see a partial file
+    char tempPath[4096];
+    FILE *out = NULL;
+    if (ok) {
+        snprintf(tempPath, sizeof(tempPath), "%s.tmp", indexPath);
+        out = fopen(tempPath, "wb");
+        ok = out != NULL;
+    }
+    if (ok) {
+        ok = fwrite(header.data, 1, header.length, out) == header.length &&
+             fwrite(files.data, 1, files.length, out) == files.length &&
+             fwrite(names.data, 1, names.length, out) == names.length &&
+             fwrite(table.data, 1, table.length, out) == table.length &&
+             fwrite(postings.data, 1, postings.length, out) == postings.length;
+        ok = fclose(out) == 0 && ok;
+        ok = ok && rename(tempPath, indexPath) == 0;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error: Cannot write cross-reference index '%s'\n", indexPath);
+    }
+    
+    free(header.data);
+    free(files.data);
+    free(names.data);
+    free(table.data);
+    free(postings.data);
+    free(fileIds);
+    free(counts);
+    free(starts);
+    free(order);
+    free(grouped);
+    free(groupedFiles);
+    return ok;
+}
+
+// Reads the names entry at offset into the names section; returns 0 if it
+// does not decode
+static int readNameEntry(int fd, const XrefLayout *layout, unsigned long long offset,
+                         unsigned char *entry, ByteReader *reader) {
+    size_t length = XREF_MAX_ENTRY_LEN;
+    if (offset >= layout->namesLen) {
+        return 0;
+    }
+    if (length > layout->namesLen - offset) {
+        length = layout->namesLen - offset;
+    }
+    reader->data = entry;
+    reader->length = length;
+    reader->position = 0;
+    reader->failed = !readAt(fd, layout->namesStart + offset, entry, length);
+    return !reader->failed;
+}
+
+// Prints "path:line:column" for every use of name. Binary-searches the name
+// table and reads only the entries it probes, the file table and one posting
+// list. Returns the number of uses found, or -1 if the index cannot be read.
+int queryXrefIndex(const char *indexPath, const char *name, FILE *fp) {
+    unsigned char header[XREF_HEADER_LEN];
+    struct stat info;
+    int fd = open(indexPath, O_RDONLY);
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        fprintf(stderr, "Error: Cannot open cross-reference index '%s'\n", indexPath);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    if (!readAt(fd, 0, header, XREF_HEADER_LEN) ||
+        memcmp(header, XREF_MAGIC, XREF_MAGIC_LEN) != 0) {
+        fprintf(stderr, "Error: '%s' is not a cross-reference index\n", indexPath);
+        close(fd);
+        return -1;
+    }
+    
+    XrefLayout layout;
+    int failed = !parseLayout(header, (unsigned long long)info.st_size, &layout);
+    
+    size_t nameLen = strlen(name);
+    unsigned long long low = 0;
+    unsigned long long high = failed ? 0 : layout.nameCount;
+    unsigned long long postingOffset = 0;
+    unsigned long long postingLen = 0;
+    unsigned long long postingCount = 0;
+    int matched = 0;
+    while (low < high && !matched && !failed) {
+        unsigned long long middle = low + (high - low) / 2;
+        unsigned char slot[8];
+        unsigned char entry[XREF_MAX_ENTRY_LEN];
+        ByteReader reader;
+        
+        if (!readAt(fd, layout.tableStart + middle * 8, slot, 8) ||
+            !readNameEntry(fd, &layout, decodeFixed(slot), entry, &reader)) {
+            failed = 1;
+            break;
+        }
+        size_t entryLen = readVarint(&reader);
+        const char *bytes = readBytes(&reader, entryLen);
+        postingOffset = readVarint(&reader);
+        postingLen = readVarint(&reader);
+        postingCount = readVarint(&reader);
+        if (reader.failed) {
+            failed = 1;
+            break;
+        }
+        
+        int order = memcmp(name, bytes, nameLen < entryLen ? nameLen : entryLen);
+        if (order == 0) {
+            order = nameLen < entryLen ? -1 : nameLen > entryLen;
+        }
+        if (order == 0) {
+            matched = 1;
+        } else if (order < 0) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+    if (matched && (postingOffset > layout.postingsLen ||
+                    postingLen > layout.postingsLen - postingOffset)) {
+        failed = 1;
+    }
+    
+    // Only path offsets are kept; the file table is tiny next to the postings
+    unsigned char *files = NULL;
+    unsigned char *postingData = NULL;
+    size_t *pathStarts = NULL;
+    size_t *pathLens = NULL;
+    if (matched && !failed) {
+        files = malloc(layout.filesLen + 1);
+        postingData = malloc(postingLen + 1);
+        pathStarts = malloc((layout.fileCount + 1) * sizeof(size_t));
+        pathLens = malloc((layout.fileCount + 1) * sizeof(size_t));
+        failed = files == NULL || postingData == NULL || pathStarts == NULL ||
+                 pathLens == NULL ||
+                 !readAt(fd, layout.filesStart, files, layout.filesLen) ||
+                 !readAt(fd, layout.postingsStart + postingOffset, postingData, postingLen);
+    }
+    close(fd);
+    
+    ByteReader fileReader = { files, layout.filesLen, 0, failed };
+    for (size_t i = 0; matched && i < layout.fileCount && !fileReader.failed; i++) {
+        pathLens[i] = readVarint(&fileReader);
+        pathStarts[i] = fileReader.position;
+        readBytes(&fileReader, pathLens[i]);
+        readVarint(&fileReader);
+        readVarint(&fileReader);
+    }
+    failed = fileReader.failed;
+    
+    int found = 0;
+    ByteReader postings = { postingData, postingLen, 0, 0 };
+    size_t fileId = 0;
+    int line = 0;
+    for (unsigned long long p = 0; matched && !failed && p < postingCount; p++) {
+        unsigned long long fileDelta = readVarint(&postings);
+        unsigned long long lineValue = readVarint(&postings);
+        int column = (int)readVarint(&postings);
+        fileId += fileDelta;
+        if (postings.failed || fileId >= layout.fileCount) {
+            failed = 1;
+            break;
+        }
+        line = fileDelta > 0 || p == 0 ? (int)lineValue : line + (int)lineValue;
+        fprintf(fp, "%.*s:%d:%d\n", (int)pathLens[fileId],
+                (const char *)files + pathStarts[fileId], line, column);
+        found++;
+    }
+    
+    free(files);
+    free(postingData);
+    free(pathStarts);
+    free(pathLens);
+    if (failed) {
+        fprintf(stderr, "Error: Cross-reference index '%s' is corrupt\n", indexPath);
+        return -1;
+    }
+    return found;
+}
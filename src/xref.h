@@ -0,0 +1,47 @@
+#ifndef XREF_H
+#define XREF_H
+
+#include <stdio.h>
+
+#define XREF_MAGIC "LXREF02\n"
+#define XREF_MAGIC_LEN 8
+#define XREF_HEADER_LEN (XREF_MAGIC_LEN + 5 * 8)
+
+// One use of an identifier inside a file
+typedef struct {
+    int symbol;     // Index into XrefIndex.names
+    int line;
+    int column;
+} XrefOccurrence;
+
+typedef struct {
+    char *path;     // NULL once the file has been dropped from the index
+    long long modified;     // Nanoseconds since the epoch
+    long long size;
+    XrefOccurrence *occurrences;
+    int count;
+    int capacity;
+} XrefFile;
+
+// Inverted identifier index over a set of files, persisted between runs
+typedef struct {
+    char **names;
+    int nameCount;
+    int nameCapacity;
+    int *slots;     // Open-addressing hash of name ids, -1 when empty
+    int slotCount;
+    XrefFile *files;
+    int fileCount;
+    int fileCapacity;
+} XrefIndex;
+
+// Function declarations
+void initXrefIndex(XrefIndex *index);
+void freeXrefIndex(XrefIndex *index);
+int loadXrefIndex(XrefIndex *index, const char *indexPath);
+int updateXrefFile(XrefIndex *index, const char *path);
+int pruneXrefIndex(XrefIndex *index);
+int saveXrefIndex(XrefIndex *index, const char *indexPath);
+int queryXrefIndex(const char *indexPath, const char *name, FILE *fp);
+
+#endif
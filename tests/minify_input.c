@@ -0,0 +1,34 @@
+/* Input for "make test": its minified form must still compile */
+#define SQUARE(x) ((x) * (x))
+#define ONE (1)
+#define MINUS_ONE -1
+#define NEG(x) -x
+
+struct point {
+    int x, y;
+};
+
+int a = 0x1E + 5;
+int b = 0xfe - 1;
+int c = 0XE + 0xE - 0x2e;
+double d = 1e+5 + 2.5E-3 - .5;
+double e = 0x1p-3 + 0x1P+2;
+double f = 1. - .25;
+int g = - -1;
+int h = + +1;
+int i = 1 - -ONE;
+const char *s = "a" "b";
+char q = '\'';
+int $a = MINUS_ONE;
+int é = NEG(1);
+int xét = 2;
+
+int main(void) {
+    struct point p = { 1, 2 };
+    struct point *pp = &p;
+    int n = a++ + ++b;
+    n += c-- - --a;
+    n = n >> 1 > 0 ? pp->x : pp -> y;
+    n = n & &n != 0;
+    return SQUARE(n) / 2 * ONE + (int)(d + e + f) + g + h + i + s[0] + q + $a + é + xét;
+}